@@ -0,0 +1,614 @@
+#include "velo_calib.h"
+#include "velo_trig_table.h"
+#include "velo_frame.h"
+#include "velo_generator.h"
+#include "common.h"
+#include <iostream>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+using namespace std;
+
+static double nowSecond()
+{
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC,&now);
+    return now.tv_sec + now.tv_nsec * 1e-9;
+}
+
+//largest coordinate gap (cm), rms of the point distance (cm) and intensity
+//mismatches against the reference cloud
+template <typename Real>
+static double maxDeviation(const CloudXYZI & ref, const CloudXYZIT<Real> & cloud, int & intensity_mismatch, double * rms = nullptr)
+{
+    intensity_mismatch = 0;
+    if(ref.point_num != cloud.point_num)
+    {
+        return HUGE_VAL;
+    }
+    double max_dev = 0;
+    double sum_sq = 0;
+    for(unsigned int i = 0; i < ref.point_num; i++)
+    {
+        double dx = ref.x[i] - cloud.x[i];
+        double dy = ref.y[i] - cloud.y[i];
+        double dz = ref.z[i] - cloud.z[i];
+        max_dev = fmax(max_dev,fmax(fabs(dx),fmax(fabs(dy),fabs(dz))));
+        sum_sq += dx * dx + dy * dy + dz * dz;
+        intensity_mismatch += ref.intensity[i] != cloud.intensity[i] || ref.line_id[i] != cloud.line_id[i];
+    }
+    if(rms != nullptr)
+    {
+        *rms = sqrt(sum_sq / (ref.point_num > 0 ? ref.point_num : 1));
+    }
+    return max_dev;
+}
+
+//the same for the fixed point cloud, the reference points are walked in order with
+//one counter per line, coordinates of the integer cloud are in 1/unit cm
+static double maxDeviation(const CloudXYZI & ref, const PointCloud & cloud, int unit, int & intensity_mismatch, double * rms)
+{
+    int line_num[LASER_NUM] = {0};
+    intensity_mismatch = 0;
+    double max_dev = 0;
+    double sum_sq = 0;
+    for(unsigned int i = 0; i < ref.point_num; i++)
+    {
+        int line = ref.line_id[i];
+        if(line_num[line] >= cloud.line_point_num[line])
+        {
+            return HUGE_VAL;
+        }
+        const Point3II & point = cloud.line_point_cloud[line][line_num[line] ++];
+        double dx = ref.x[i] - (double)point.x / unit;
+        double dy = ref.y[i] - (double)point.y / unit;
+        double dz = ref.z[i] - (double)point.z / unit;
+        max_dev = fmax(max_dev,fmax(fabs(dx),fmax(fabs(dy),fabs(dz))));
+        sum_sq += dx * dx + dy * dy + dz * dz;
+        intensity_mismatch += ref.intensity[i] != point.intensity;
+    }
+    *rms = sqrt(sum_sq / (ref.point_num > 0 ? ref.point_num : 1));
+    return max_dev;
+}
+
+//the original per point conversion over a whole frame
+static void convFrameRef(VeloCalib & calib, const FrameData & frame, CloudXYZI & cloud)
+{
+    PointLRDI point;
+    Point3FI out;
+    cloud.point_num = 0;
+    for(unsigned int i = 0; i < frame.block_num; i++)
+    {
+        const Block & block = frame.frame_block[i];
+        point.rot_angle = block.rot_angle;
+        for(int k = 0; k < 32; k++)
+        {
+            point.line_id = k + (block.upper_or_lower == 0xDDFF ? 32 : 0);
+            point.distance = block.fire_laser[k].distance;
+            point.intensity = block.fire_laser[k].intensity;
+            if(calib.convLRDI2XYZIRef(&point,out))
+            {
+                unsigned int n = cloud.point_num ++;
+                cloud.x[n] = out.x;
+                cloud.y[n] = out.y;
+                cloud.z[n] = out.z;
+                cloud.intensity[n] = out.intensity;
+                cloud.line_id[n] = point.line_id;
+            }
+        }
+    }
+}
+
+//per point conversion of every raw point, then the rules of the filter on the raw data and the point
+static void convFrameFilterRef(VeloCalib & calib, const CompactFrame & compact, const CalibFilter & filter,
+                               CloudXYZI & cloud, FilterCount & count)
+{
+    PointLRDI point;
+    Point3FI out;
+    cloud.point_num = 0;
+    count = FilterCount();
+    for(unsigned int i = 0; i < compact.block_num; i++)
+    {
+        point.rot_angle = compact.rot_angle[i];
+        int rot_angle = point.rot_angle;
+        bool sector = filter.sector_num == 0;
+        for(int j = 0; j < filter.sector_num; j++)
+        {
+            int start = filter.sector_start[j];
+            int end = filter.sector_end[j];
+            sector = sector || (start <= end ? (rot_angle >= start && rot_angle < end) :
+                                               (rot_angle >= start || rot_angle < end));
+        }
+        for(int k = 0; k < 32; k++)
+        {
+            point.line_id = k + (compact.upper_or_lower[i] == 0xDDFF ? 32 : 0);
+            point.distance = compact.distance[i][k];
+            point.intensity = compact.intensity[i][k];
+            if(!calib.convLRDI2XYZI(&point,out))
+            {
+                continue;
+            }
+            bool in_region = out.x >= filter.region[0] && out.x <= filter.region[1] && out.y >= filter.region[2] &&
+                             out.y <= filter.region[3] && out.z >= filter.region[4] && out.z <= filter.region[5];
+            bool in_body = out.x >= filter.body[0] && out.x <= filter.body[1] && out.y >= filter.body[2] &&
+                           out.y <= filter.body[3] && out.z >= filter.body[4] && out.z <= filter.body[5];
+            int rule = !sector ? FILTER_SECTOR :
+                       !((filter.laser_mask >> point.line_id) & 1) ? FILTER_LASER :
+                       (point.distance < filter.min_distance || point.distance > filter.max_distance) ? FILTER_DISTANCE :
+                       (filter.region_enable && !in_region) ? FILTER_REGION :
+                       (filter.body_enable && in_body) ? FILTER_BODY : FILTER_RULE_NUM;
+            if(rule != FILTER_RULE_NUM)
+            {
+                count.rejected[rule] ++;
+                continue;
+            }
+            unsigned int n = cloud.point_num ++;
+            cloud.x[n] = out.x;
+            cloud.y[n] = out.y;
+            cloud.z[n] = out.z;
+            cloud.intensity[n] = out.intensity;
+            cloud.line_id[n] = point.line_id;
+        }
+    }
+}
+
+//construction from the xml and from the binary cache,
+//points/s of the per point conversions and of the batch conversions, one 64E frame,
+//then the single precision and the fixed point conversions and their accuracy against the double reference
+//usage: velo_calib_bench [calib_file] [loop_num]
+int main(int argc, char ** argv)
+{
+    char default_file[128] = "../S3735.xml";
+    char * calib_file = argc > 1 ? argv[1] : default_file;
+    int loop_num = argc > 2 ? atoi(argv[2]) : 50;
+    char cache_file[128] = "velo_calib_bench.cache";
+    remove(cache_file);
+
+    //stp0. startup: the first instance, later ones, the same writing the cache, then mapping the cache
+    printf("LOG:calibration object %zu bytes, tables %zu bytes of constant data\n",
+           sizeof(VeloCalib),sizeof(velo_trig_table_double));
+    const char * names_c[4] = {"first construct from xml","construct from xml","construct, write cache","construct from cache"};
+    for(int mode = 0; mode < 4; mode++)
+    {
+        int construct_num = mode == 0 || mode == 2 ? 1 : 10;
+        double start_time = nowSecond();
+        for(int l = 0; l < construct_num; l++)
+        {
+            VeloCalib * calib = new VeloCalib(calib_file,mode <= 1 ? nullptr : cache_file);
+            delete calib;
+        }
+        printf("LOG:%-26s %10.3f ms\n",names_c[mode],(nowSecond() - start_time) * 1e3 / construct_num);
+    }
+    VeloCalib * calib = new VeloCalib(calib_file,cache_file);
+    if(!calib->valid())
+    {
+        delete calib;
+        return -1;
+    }
+
+    //stp1. one revolution of the room scene in both frame layouts
+    GeneratorConfig generator_config;
+    VeloGenerator::defaultConfig(generator_config);
+    generator_config.scene = SCENE_ROOM;
+    VeloGenerator generator(&generator_config);
+    unsigned int max_block_num = frameBlockNum(64,generator_config.rpm);
+    unsigned int packet_num = (unsigned int)(60e6 / generator_config.rpm / generator.packetPeriod());
+    CompactFrame_ptr compact = createCompactFrame(max_block_num);
+    FrameData_ptr frame = createFrameData(max_block_num);
+    VeloDecoder decoder;
+    unsigned char packet[1206];
+    for(unsigned int i = 0; i < packet_num; i++)
+    {
+        generator.buildPacket(packet);
+        appendPacket(decoder,packet,compact);
+    }
+    compactToFrame(compact,frame);
+    unsigned int raw_num = compact->block_num * 32;
+    unsigned char * line_id = new unsigned char[raw_num];
+    unsigned short * rot_angle = new unsigned short[raw_num];
+    for(unsigned int i = 0; i < raw_num; i++)
+    {
+        line_id[i] = i % 32 + (compact->upper_or_lower[i / 32] == 0xDDFF ? 32 : 0);
+        rot_angle[i] = compact->rot_angle[i / 32];
+    }
+    printf("LOG:%u blocks, %u raw points per frame\n",compact->block_num,raw_num);
+
+    //stp2. reference: the original math, one convLRDI2XYZIRef call per point
+    CloudXYZI_ptr ref = createCloudXYZI(raw_num);
+    CloudXYZI_ptr cloud = createCloudXYZI(raw_num);
+    double start_time = nowSecond();
+    for(int l = 0; l < loop_num; l++)
+    {
+        convFrameRef(*calib,*frame,*ref);
+    }
+    double elapsed = nowSecond() - start_time;
+    double base_rate = (double)raw_num * loop_num / elapsed;
+    printf("LOG:%-26s %12.0f points/s  x%.2f  %u points\n","reference FrameData",base_rate,1.0,ref->point_num);
+
+    //stp3. per point with the laser coefficients, then the batch entry points on the best instruction set
+    const char * names[4] = {"scalar FrameData","batch FrameData","batch CompactFrame","batch arrays"};
+    for(int mode = 0; mode < 4; mode++)
+    {
+        if(mode == 1 && calib->setLevel(CALIB_AUTO) != CALIB_AVX2)
+        {
+            printf("WRN:no AVX2/FMA on this cpu, the batch conversions run scalar\n");
+        }
+        if(mode == 0)
+        {
+            calib->setLevel(CALIB_SCALAR);
+        }
+        start_time = nowSecond();
+        for(int l = 0; l < loop_num; l++)
+        {
+            if(mode <= 1)
+            {
+                calib->convFrame(frame,*cloud);
+            }
+            else if(mode == 2)
+            {
+                calib->convFrame(compact,*cloud);
+            }
+            else
+            {
+                cloud->point_num = 0;
+                calib->convLRDI2XYZI(line_id,rot_angle,compact->distance[0],compact->intensity[0],raw_num,*cloud);
+            }
+        }
+        elapsed = nowSecond() - start_time;
+        double rate = (double)raw_num * loop_num / elapsed;
+        int intensity_mismatch = 0;
+        double max_dev = maxDeviation(*ref,*cloud,intensity_mismatch);
+        printf("LOG:%-26s %12.0f points/s  x%.2f  max deviation %.3g cm, %d intensity/line mismatches\n",
+               names[mode],rate,rate / base_rate,max_dev,intensity_mismatch);
+    }
+
+    //stp4. single precision
+    VeloCalibF * calib_f = new VeloCalibF(calib_file);
+    CloudXYZIf_ptr cloud_f = createCloudXYZIf(raw_num);
+    printf("LOG:calibration tables %zu bytes double, %zu bytes float; cloud %zu / %zu bytes per point\n",
+           2 * 36000 * sizeof(double),2 * 36000 * sizeof(float),3 * sizeof(double) + 2,3 * sizeof(float) + 2);
+    const char * names_f[3] = {"float scalar FrameData","float batch FrameData","float batch CompactFrame"};
+    for(int mode = 0; mode < 3; mode++)
+    {
+        calib_f->setLevel(mode == 0 ? CALIB_SCALAR : CALIB_AUTO);
+        start_time = nowSecond();
+        for(int l = 0; l < loop_num; l++)
+        {
+            if(mode <= 1)
+            {
+                calib_f->convFrame(frame,*cloud_f);
+            }
+            else
+            {
+                calib_f->convFrame(compact,*cloud_f);
+            }
+        }
+        elapsed = nowSecond() - start_time;
+        double rate = (double)raw_num * loop_num / elapsed;
+        int intensity_mismatch = 0;
+        double rms = 0;
+        double max_dev = maxDeviation(*ref,*cloud_f,intensity_mismatch,&rms);
+        printf("LOG:%-26s %12.0f points/s  x%.2f  max deviation %.3g cm, rms %.3g cm, %d intensity/line mismatches\n",
+               names_f[mode],rate,rate / base_rate,max_dev,rms,intensity_mismatch);
+    }
+
+    //stp5. fixed point into PointCloud, cm and mm
+    PointCloud_ptr point_cloud = createPointCloud(frameLinePointNum(64,generator_config.rpm));
+    printf("LOG:fixed point tables %zu bytes\n",2 * 36000 * sizeof(short) + 2 * sizeof(LaserCoeffInt));
+    const char * names_i[4] = {"int cm scalar CompactFrame","int cm batch CompactFrame","int mm scalar CompactFrame","int mm batch CompactFrame"};
+    for(int mode = 0; mode < 4; mode++)
+    {
+        int unit = mode < 2 ? INT_UNIT_CM : INT_UNIT_MM;
+        calib->setLevel(mode % 2 == 0 ? CALIB_SCALAR : CALIB_AUTO);
+        start_time = nowSecond();
+        for(int l = 0; l < loop_num; l++)
+        {
+            memset(point_cloud->line_point_num,0,sizeof(point_cloud->line_point_num));
+            calib->convFrame(compact,*point_cloud,unit);
+        }
+        elapsed = nowSecond() - start_time;
+        double rate = (double)raw_num * loop_num / elapsed;
+        int intensity_mismatch = 0;
+        double rms = 0;
+        double max_dev = maxDeviation(*ref,*point_cloud,unit,intensity_mismatch,&rms);
+        printf("LOG:%-26s %12.0f points/s  x%.2f  max deviation %.3g cm, rms %.3g cm, %d intensity mismatches\n",
+               names_i[mode],rate,rate / base_rate,max_dev,rms,intensity_mismatch);
+    }
+
+    //stp6. the calibration from the cache gives the same points
+    VeloCalib * calib_cache = new VeloCalib(calib_file,nullptr);
+    calib_cache->convFrame(compact,*cloud);
+    calib->convFrame(compact,*ref);
+    int cache_mismatch = 0;
+    printf("LOG:cache against xml: max deviation %.3g cm, %d intensity/line mismatches\n",
+           maxDeviation(*ref,*cloud,cache_mismatch),cache_mismatch);
+    delete calib_cache;
+    remove(cache_file);
+
+    //stp7. extrinsic: a separate pass over the cloud against the transform inside the conversion
+    const double yaw = 30 * M_PI / 180;
+    const double pitch = 2 * M_PI / 180;
+    const double matrix[4][4] =
+    {
+        {cos(yaw) * cos(pitch), -sin(yaw), cos(yaw) * sin(pitch), 120},
+        {sin(yaw) * cos(pitch), cos(yaw), sin(yaw) * sin(pitch), -35},
+        {-sin(pitch), 0, cos(pitch), 180},
+        {0, 0, 0, 1}
+    };
+    calib->setLevel(CALIB_AUTO);
+    calib->setExtrinsic(nullptr);
+    start_time = nowSecond();
+    for(int l = 0; l < loop_num; l++)
+    {
+        calib->convFrame(compact,*ref);
+        for(unsigned int i = 0; i < ref->point_num; i++)
+        {
+            double x = ref->x[i];
+            double y = ref->y[i];
+            double z = ref->z[i];
+            ref->x[i] = matrix[0][0] * x + matrix[0][1] * y + matrix[0][2] * z + matrix[0][3];
+            ref->y[i] = matrix[1][0] * x + matrix[1][1] * y + matrix[1][2] * z + matrix[1][3];
+            ref->z[i] = matrix[2][0] * x + matrix[2][1] * y + matrix[2][2] * z + matrix[2][3];
+        }
+    }
+    double two_pass_rate = (double)raw_num * loop_num / (nowSecond() - start_time);
+    calib->setExtrinsic(matrix);
+    start_time = nowSecond();
+    for(int l = 0; l < loop_num; l++)
+    {
+        calib->convFrame(compact,*cloud);
+    }
+    double fused_rate = (double)raw_num * loop_num / (nowSecond() - start_time);
+    int extrinsic_mismatch = 0;
+    double extrinsic_dev = maxDeviation(*ref,*cloud,extrinsic_mismatch);
+    calib->setLevel(CALIB_SCALAR);
+    calib->convFrame(compact,*cloud);
+    double scalar_dev = maxDeviation(*ref,*cloud,extrinsic_mismatch);
+    calib->setLevel(CALIB_AUTO);
+    memset(point_cloud->line_point_num,0,sizeof(point_cloud->line_point_num));
+    calib->convFrame(compact,*point_cloud,INT_UNIT_MM);
+    double int_rms = 0;
+    double int_dev = maxDeviation(*ref,*point_cloud,INT_UNIT_MM,extrinsic_mismatch,&int_rms);
+    printf("LOG:extrinsic separate pass %12.0f points/s, in the conversion %12.0f points/s  x%.2f\n",
+           two_pass_rate,fused_rate,fused_rate / two_pass_rate);
+    printf("LOG:extrinsic max deviation batch %.3g cm, scalar %.3g cm, int mm %.3g cm\n",extrinsic_dev,scalar_dev,int_dev);
+    calib->setExtrinsic(nullptr);
+
+    //stp8. early rejection for a grid map: 1 m to 12 m, the front half, no top 8 lasers,
+    //a 24 m x 16 m box in a z band, out of the ego vehicle (sensor at its back, 7 m ahead).
+    //against the whole conversion then a pass
+    CalibFilter filter;
+    VeloCalib::defaultFilter(filter);
+    filter.min_distance = 500;
+    filter.max_distance = 6000;
+    filter.sector_num = 1;
+    filter.sector_start[0] = 27000;
+    filter.sector_end[0] = 9000;
+    for(int n = 1; n <= 8; n++)
+    {
+        filter.laser_mask &= ~(1ULL << calib->getTopXLaser(n));
+    }
+    const double region[6] = {-1200,1200,-800,800,-250,200};
+    const double body[6] = {-120,120,-100,700,-250,200};
+    filter.region_enable = 1;
+    filter.body_enable = 1;
+    memcpy(filter.region,region,sizeof(region));
+    memcpy(filter.body,body,sizeof(body));
+    FilterCount ref_count;
+    convFrameFilterRef(*calib,*compact,filter,*ref,ref_count);
+    start_time = nowSecond();
+    for(int l = 0; l < loop_num; l++)
+    {
+        calib->convFrame(compact,*cloud);
+        unsigned int n = 0;
+        for(unsigned int i = 0; i < cloud->point_num; i++)
+        {
+            double x = cloud->x[i];
+            double y = cloud->y[i];
+            double z = cloud->z[i];
+            double range_sqr = x * x + y * y + z * z;
+            bool in_region = x >= region[0] && x <= region[1] && y >= region[2] && y <= region[3] && z >= region[4] && z <= region[5];
+            bool in_body = x >= body[0] && x <= body[1] && y >= body[2] && y <= body[3] && z >= body[4] && z <= body[5];
+            if(range_sqr < 100 * 100 || range_sqr > 1200 * 1200 || y < 0 || !((filter.laser_mask >> cloud->line_id[i]) & 1) ||
+               !in_region || in_body)
+            {
+                continue;
+            }
+            cloud->x[n] = x;
+            cloud->y[n] = y;
+            cloud->z[n] = z;
+            cloud->intensity[n] = cloud->intensity[i];
+            cloud->line_id[n] = cloud->line_id[i];
+            n ++;
+        }
+        cloud->point_num = n;
+    }
+    double pass_rate = (double)raw_num * loop_num / (nowSecond() - start_time);
+    calib->setFilter(&filter);
+    start_time = nowSecond();
+    for(int l = 0; l < loop_num; l++)
+    {
+        calib->convFrame(compact,*cloud);
+    }
+    double filter_rate = (double)raw_num * loop_num / (nowSecond() - start_time);
+    printf("LOG:filter convert then reject %12.0f points/s, rejected in the conversion %12.0f points/s  x%.2f\n",
+           pass_rate,filter_rate,filter_rate / pass_rate);
+    const char * rule_names[FILTER_RULE_NUM] = {"sector","laser","distance","region","body"};
+    printf("LOG:filter kept %u of %u points, rejected",ref->point_num,raw_num);
+    for(int r = 0; r < FILTER_RULE_NUM; r++)
+    {
+        printf(" %s %llu",rule_names[r],ref_count.rejected[r]);
+    }
+    printf("\n");
+    const char * names_r[4] = {"batch","scalar","arrays","float"};
+    for(int mode = 0; mode < 4; mode++)
+    {
+        calib->setLevel(mode == 1 ? CALIB_SCALAR : CALIB_AUTO);
+        calib->resetFilterCount();
+        int filter_mismatch = 0;
+        double filter_dev;
+        const FilterCount * count = &calib->getFilterCount();
+        if(mode == 3)
+        {
+            calib_f->setFilter(&filter);
+            calib_f->resetFilterCount();
+            calib_f->convFrame(compact,*cloud_f);
+            filter_dev = maxDeviation(*ref,*cloud_f,filter_mismatch);
+            count = &calib_f->getFilterCount();
+        }
+        else if(mode == 2)
+        {
+            cloud->point_num = 0;
+            calib->convLRDI2XYZI(line_id,rot_angle,compact->distance[0],compact->intensity[0],raw_num,*cloud);
+            filter_dev = maxDeviation(*ref,*cloud,filter_mismatch);
+        }
+        else
+        {
+            calib->convFrame(compact,*cloud);
+            filter_dev = maxDeviation(*ref,*cloud,filter_mismatch);
+        }
+        bool count_ok = memcmp(count,&ref_count,sizeof(ref_count)) == 0;
+        printf("LOG:filter %-8s max deviation %.3g cm, counters %s\n",names_r[mode],filter_dev,count_ok ? "match" : "differ");
+    }
+    memset(point_cloud->line_point_num,0,sizeof(point_cloud->line_point_num));
+    int int_num = calib->convFrame(compact,*point_cloud,INT_UNIT_MM);
+    printf("LOG:filter int mm kept %d points\n",int_num);
+    calib->setFilter(nullptr);
+    calib_f->setFilter(nullptr);
+    freePointCloud(point_cloud);
+
+    //stp9. organized range image, columns of 0.16 degree below the firing step so that no two
+    //blocks share a cell: every point of the cloud is found in the cell of its row and block
+    RangeImage_ptr image = createRangeImage(16);
+    calib->setLevel(CALIB_AUTO);
+    start_time = nowSecond();
+    for(int l = 0; l < loop_num; l++)
+    {
+        calib->convFrame(compact,*image);
+    }
+    double image_rate = (double)raw_num * loop_num / (nowSecond() - start_time);
+    start_time = nowSecond();
+    for(int l = 0; l < loop_num; l++)
+    {
+        calib->convFrame(compact,*cloud);
+    }
+    double cloud_rate = (double)raw_num * loop_num / (nowSecond() - start_time);
+    unsigned char line_row[LASER_NUM];
+    for(int r = 0; r < image->row_num; r++)
+    {
+        line_row[image->row_line[r]] = r;
+    }
+    unsigned int image_mismatch = 0;
+    unsigned int n = 0;
+    for(unsigned int i = 0; i < compact->block_num; i++)
+    {
+        int line_base = compact->upper_or_lower[i] == 0xDDFF ? 32 : 0;
+        for(int k = 0; k < 32; k++)
+        {
+            if(compact->distance[i][k] == 0)
+            {
+                continue;
+            }
+            size_t cell = (size_t)(compact->rot_angle[i] / image->azimuth_step) * image->row_num + line_row[line_base + k];
+            image_mismatch += image->x[cell] != cloud->x[n] || image->y[cell] != cloud->y[n] ||
+                              image->z[cell] != cloud->z[n] || image->range[cell] <= 0 ? 1 : 0;
+            n ++;
+        }
+    }
+    printf("LOG:range image %d x %d, %u of %u points in cells, %u misplaced, %12.0f points/s, cloud %12.0f points/s\n",
+           image->row_num,image->column_num,image->point_num,cloud->point_num,image_mismatch,image_rate,cloud_rate);
+    freeRangeImage(image);
+
+    //stp10. de-skew at 10 m/s and 30 degree/s of yaw, ego poses every 10 ms, the frame moved into the
+    //vehicle at its last block: a separate pass over the cloud against the pose inside the conversion
+    unsigned int first_time = compact->gps_time_stampe[0];
+    unsigned int last_time = compact->gps_time_stampe[compact->block_num - 1];
+    unsigned int time_error = 0;
+    for(unsigned int i = 1; i < compact->block_num; i++)
+    {
+        unsigned int gap = compact->gps_time_stampe[i] - compact->gps_time_stampe[i - 1];
+        time_error += compact->upper_or_lower[i] == 0xDDFF ? (gap != 0) : (gap != 48);
+    }
+    const int pose_num = 13;
+    EgoPose poses[pose_num];
+    for(int i = 0; i < pose_num; i++)
+    {
+        //the first pose before the frame, us past the hour
+        poses[i].time = (unsigned int)((first_time + 3600000000ULL + (i - 1) * 10000) % 3600000000ULL);
+        double t = (double)(i - 1) * 0.01;
+        poses[i].position[0] = 10.0 * t;
+        poses[i].position[1] = 0;
+        poses[i].position[2] = 0;
+        poses[i].rpy[0] = 0;
+        poses[i].rpy[1] = 0;
+        poses[i].rpy[2] = 30.0 * t;
+    }
+    double ref_t = (last_time - first_time) * 1e-6;
+    //separate pass: the block of every point, then its pose against the one at the reference time
+    CloudXYZI_ptr deskew_ref = createCloudXYZI(raw_num);
+    start_time = nowSecond();
+    for(int l = 0; l < loop_num; l++)
+    {
+        calib->convFrame(compact,*deskew_ref);
+        n = 0;
+        for(unsigned int i = 0; i < compact->block_num; i++)
+        {
+            double t = (compact->gps_time_stampe[i] - first_time) * 1e-6;
+            double yaw = (30.0 * (t - ref_t)) * M_PI / 180.0;
+            double cy = cos(yaw);
+            double sy = sin(yaw);
+            double yaw_ref = 30.0 * ref_t * M_PI / 180.0;
+            double dx = 1000.0 * (t - ref_t);
+            double tx = cos(yaw_ref) * dx;
+            double ty = -sin(yaw_ref) * dx;
+            for(int k = 0; k < 32; k++)
+            {
+                if(compact->distance[i][k] == 0)
+                {
+                    continue;
+                }
+                double x = deskew_ref->x[n];
+                double y = deskew_ref->y[n];
+                deskew_ref->x[n] = cy * x - sy * y + tx;
+                deskew_ref->y[n] = sy * x + cy * y + ty;
+                n ++;
+            }
+        }
+    }
+    double pass_deskew_rate = (double)raw_num * loop_num / (nowSecond() - start_time);
+    calib->setDeskew(poses,pose_num,last_time);
+    calib_f->setDeskew(poses,pose_num,last_time);
+    start_time = nowSecond();
+    for(int l = 0; l < loop_num; l++)
+    {
+        calib->convFrame(compact,*cloud);
+    }
+    double deskew_rate = (double)raw_num * loop_num / (nowSecond() - start_time);
+    int deskew_mismatch = 0;
+    double deskew_dev = maxDeviation(*deskew_ref,*cloud,deskew_mismatch);
+    calib->setLevel(CALIB_SCALAR);
+    calib->convFrame(compact,*cloud);
+    double deskew_scalar_dev = maxDeviation(*deskew_ref,*cloud,deskew_mismatch);
+    calib->setLevel(CALIB_AUTO);
+    calib_f->convFrame(compact,*cloud_f);
+    double deskew_float_dev = maxDeviation(*deskew_ref,*cloud_f,deskew_mismatch);
+    printf("LOG:deskew %u block time errors, max deviation batch %.3g scalar %.3g float %.3g cm\n",
+           time_error,deskew_dev,deskew_scalar_dev,deskew_float_dev);
+    printf("LOG:deskew separate pass %12.0f points/s, in the conversion %12.0f points/s  x%.2f\n",
+           pass_deskew_rate,deskew_rate,deskew_rate / pass_deskew_rate);
+    calib->setDeskew(nullptr,0,0);
+    calib_f->setDeskew(nullptr,0,0);
+    freeCloudXYZI(deskew_ref);
+
+    delete calib_f;
+    freeCloudXYZI(cloud_f);
+    freeCloudXYZI(ref);
+    freeCloudXYZI(cloud);
+    delete [] line_id;
+    delete [] rot_angle;
+    freeFrameData(frame);
+    freeCompactFrame(compact);
+    delete calib;
+    return 0;
+}
@@ -0,0 +1,237 @@
+#include "velo_decoder.h"
+#include "velo_frame.h"
+#include "velo_driver.h"
+#include "velo_generator.h"
+#include "common.h"
+#include <iostream>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+using namespace std;
+
+#define PACKET_SIZE 1206
+
+static double nowSecond()
+{
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC,&now);
+    return now.tv_sec + now.tv_nsec * 1e-9;
+}
+
+//the array of structs decoding done by VeloDriver::analysePacket
+static void decodeAoS(const unsigned char * p_data, Block_ptr blocks)
+{
+    for(int block_index = 0; block_index < 12; block_index++)
+    {
+        blocks[block_index].upper_or_lower = (p_data[1]<<8) + p_data[0];
+        blocks[block_index].block_id = block_index;
+        blocks[block_index].rot_angle = (p_data[3]<<8) + p_data[2];
+        p_data += 4;
+        for(int laser_index = 0; laser_index < 32; laser_index++)
+        {
+            blocks[block_index].fire_laser[laser_index].distance = ((p_data[1] << 8) + p_data[0]);
+            blocks[block_index].fire_laser[laser_index].intensity = p_data[2];
+            p_data += 3;
+        }
+    }
+}
+
+//blocks whose firing time does not follow the one before: the same azimuth is fired at the same
+//time, the next one block_period later (+-1 us of the packet timestamp and the rounding)
+static unsigned int timeErrorNum(const CompactFrame * compact, double block_period)
+{
+    unsigned int error_num = 0;
+    for(unsigned int b = 1; b < compact->block_num; b++)
+    {
+        double gap = (double)compact->gps_time_stampe[b] - compact->gps_time_stampe[b - 1];
+        double expect = compact->rot_angle[b] == compact->rot_angle[b - 1] ? 0 : block_period;
+        error_num += fabs(gap - expect) >= 2.0;
+    }
+    return error_num;
+}
+
+//the same for a frame of the driver
+static unsigned int timeErrorNum(const FrameData * frame, double block_period)
+{
+    unsigned int error_num = 0;
+    for(unsigned int b = 1; b < frame->block_num; b++)
+    {
+        const Block & block = frame->frame_block[b];
+        const Block & last = frame->frame_block[b - 1];
+        double gap = (double)block.gps_time_stampe - last.gps_time_stampe;
+        double expect = block.rot_angle == last.rot_angle ? 0 : block_period;
+        error_num += fabs(gap - expect) >= 2.0;
+    }
+    return error_num;
+}
+
+//packets/s of the scalar AoS path and every decoder level, then the sensor detection and the
+//appenders and the driver on every model and return mode
+//usage: velo_decoder_bench [packet_num] [loop_num]
+int main(int argc, char ** argv)
+{
+    int packet_num = argc > 1 ? atoi(argv[1]) : 4096;
+    int loop_num = argc > 2 ? atoi(argv[2]) : 200;
+    GeneratorConfig generator_config;
+    VeloGenerator::defaultConfig(generator_config);
+    generator_config.scene = SCENE_ROOM;
+    VeloGenerator generator(&generator_config);
+    unsigned char * packets = new unsigned char[(size_t)packet_num * PACKET_SIZE];
+    for(int i = 0; i < packet_num; i++)
+    {
+        generator.buildPacket(packets + (size_t)i * PACKET_SIZE);
+    }
+
+    //stp1. reference: blocks of packed Laser structs
+    Block * blocks = new Block[12];
+    double start_time = nowSecond();
+    unsigned long long check_sum = 0;
+    for(int l = 0; l < loop_num; l++)
+    {
+        for(int i = 0; i < packet_num; i++)
+        {
+            decodeAoS(packets + (size_t)i * PACKET_SIZE,blocks);
+            check_sum += blocks[11].fire_laser[31].distance;
+        }
+    }
+    double elapsed = nowSecond() - start_time;
+    double base_rate = (double)packet_num * loop_num / elapsed;
+    printf("LOG:%-14s %12.0f packets/s  x%.2f  (%llu)\n","scalar AoS",base_rate,1.0,check_sum);
+
+    //stp2. every decoder level, checked against the reference
+    const char * level_names[3] = {"scalar SoA","SSE4.1 SoA","AVX2 SoA"};
+    DecodedPacket * decoded = new DecodedPacket;
+    for(int level = DECODER_SCALAR; level <= VeloDecoder::cpuLevel(); level++)
+    {
+        VeloDecoder decoder(level);
+        int mismatch = 0;
+        for(int i = 0; i < packet_num; i++)
+        {
+            decodeAoS(packets + (size_t)i * PACKET_SIZE,blocks);
+            decoder.decode(packets + (size_t)i * PACKET_SIZE,*decoded);
+            for(int b = 0; b < 12; b++)
+            {
+                mismatch += blocks[b].rot_angle != decoded->rot_angle[b] ||
+                        blocks[b].upper_or_lower != decoded->upper_or_lower[b];
+                for(int k = 0; k < 32; k++)
+                {
+                    mismatch += blocks[b].fire_laser[k].distance != decoded->distance[b][k] ||
+                            blocks[b].fire_laser[k].intensity != decoded->intensity[b][k];
+                }
+            }
+        }
+        check_sum = 0;
+        start_time = nowSecond();
+        for(int l = 0; l < loop_num; l++)
+        {
+            for(int i = 0; i < packet_num; i++)
+            {
+                decoder.decode(packets + (size_t)i * PACKET_SIZE,*decoded);
+                check_sum += decoded->distance[11][31];
+            }
+        }
+        elapsed = nowSecond() - start_time;
+        double rate = (double)packet_num * loop_num / elapsed;
+        printf("LOG:%-14s %12.0f packets/s  x%.2f  (%llu) %s\n",level_names[level],rate,rate / base_rate,check_sum,
+               mismatch == 0 ? "match" : "MISMATCH");
+    }
+
+    //stp3. one revolution of every model and return mode: detected from its first packet, appended
+    //by the generic appendPacket and by the specialized appender into a frame sized for the sensor,
+    //then three revolutions through the driver finding the sensor itself
+    const int models[3] = {MODEL_HDL64E,MODEL_HDL32E,MODEL_VLP16};
+    const int model_lasers[3] = {64,32,16};
+    const char * model_names[3] = {"HDL-64E","HDL-32E","VLP-16"};
+    const int return_modes[2] = {RETURN_STRONGEST,RETURN_DUAL};
+    const char * return_names[2] = {"strongest","dual"};
+    VeloDecoder decoder;
+    for(int m = 0; m < 3; m++)
+    {
+        for(int r = 0; r < 2; r++)
+        {
+            GeneratorConfig sensor_config;
+            VeloGenerator::defaultConfig(sensor_config);
+            sensor_config.scene = SCENE_ROOM;
+            sensor_config.laser_num = model_lasers[m];
+            sensor_config.return_mode = return_modes[r];
+            VeloGenerator sensor_generator(&sensor_config);
+            int frame_packet_num = (int)(60e6 / sensor_config.rpm / sensor_generator.packetPeriod());
+            unsigned char * frame_packets = new unsigned char[(size_t)frame_packet_num * 3 * PACKET_SIZE];
+            for(int i = 0; i < frame_packet_num * 3; i++)
+            {
+                sensor_generator.buildPacket(frame_packets + (size_t)i * PACKET_SIZE);
+            }
+            SensorInfo sensor;
+            detectSensor(frame_packets,sensor);
+            bool detected = sensor.model == models[m] && sensor.return_mode == return_modes[r];
+            AppendPacketFunc appender = packetAppender(sensor);
+            CompactFrame_ptr compact = createCompactFrame(frameBlockNum(sensor,sensor_config.rpm));
+            const SensorLayout & layout = sensorLayout(models[m]);
+            double block_period = layout.firing_per_block * layout.firing_period;
+
+            //generic appender, firing times from the block headers
+            int full_num = 0;
+            for(int i = 0; i < frame_packet_num; i++)
+            {
+                full_num += !appendPacket(decoder,frame_packets + (size_t)i * PACKET_SIZE,compact);
+            }
+            unsigned int generic_error_num = timeErrorNum(compact,block_period);
+
+            //specialized appender, checked then timed
+            compact->block_num = 0;
+            for(int i = 0; i < frame_packet_num; i++)
+            {
+                full_num += !appender(decoder,frame_packets + (size_t)i * PACKET_SIZE,compact);
+            }
+            unsigned int error_num = timeErrorNum(compact,block_period);
+            start_time = nowSecond();
+            for(int l = 0; l < loop_num; l++)
+            {
+                compact->block_num = 0;
+                for(int i = 0; i < frame_packet_num; i++)
+                {
+                    appender(decoder,frame_packets + (size_t)i * PACKET_SIZE,compact);
+                }
+            }
+            elapsed = nowSecond() - start_time;
+            printf("LOG:%-8s %-9s %s, %u/%u blocks%s, time errors %u generic %u specialized, %12.0f packets/s\n",
+                   model_names[m],return_names[r],detected ? "detected" : "NOT DETECTED",compact->block_num,
+                   compact->max_block_num,full_num > 0 ? " FULL" : "",generic_error_num,error_num,
+                   (double)frame_packet_num * loop_num / elapsed);
+
+            //the driver, frames between the cuts
+            MemorySource source((const char *)frame_packets,frame_packet_num * 3);
+            DriverConfig driver_config;
+            VeloDriver::defaultConfig(driver_config);
+            driver_config.batch_num = 32;
+            driver_config.drop_policy = QUEUE_BLOCK;
+            driver_config.rpm = sensor_config.rpm;
+            unsigned int driver_frame_num = 0;
+            unsigned int driver_error_num = 0;
+            DriverStats stats;
+            SensorInfo driver_sensor;
+            {
+                VeloDriver velo_driver(&source,&driver_config);
+                while(velo_driver.newData())
+                {
+                    driver_frame_num ++;
+                    driver_error_num += timeErrorNum(velo_driver.raw_data,block_period);
+                }
+                velo_driver.getStats(stats);
+                driver_sensor = velo_driver.getSensor();
+            }
+            bool driver_detected = driver_sensor.model == models[m] && driver_sensor.return_mode == return_modes[r];
+            printf("LOG:%-8s %-9s driver %s, %u frames, %llu overflow blocks, time errors %u\n",model_names[m],
+                   return_names[r],driver_detected ? "detected" : "NOT DETECTED",driver_frame_num,
+                   stats.overflow_blocks,driver_error_num);
+            freeCompactFrame(compact);
+            delete [] frame_packets;
+        }
+    }
+
+    delete decoded;
+    delete [] blocks;
+    delete [] packets;
+    return 0;
+}
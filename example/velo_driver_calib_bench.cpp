@@ -0,0 +1,116 @@
+#include "velo_driver.h"
+#include "velo_calib.h"
+#include "velo_frame.h"
+#include "velo_generator.h"
+#include <iostream>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+using namespace std;
+
+static double nowSecond()
+{
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC,&now);
+    return now.tv_sec + now.tv_nsec * 1e-9;
+}
+
+//largest coordinate gap (cm) between two clouds of the same points
+static double maxDeviation(const CloudXYZI & ref, const CloudXYZI & cloud)
+{
+    if(ref.point_num != cloud.point_num)
+    {
+        return HUGE_VAL;
+    }
+    double max_dev = 0;
+    for(unsigned int i = 0; i < ref.point_num; i++)
+    {
+        max_dev = fmax(max_dev,fabs(ref.x[i] - cloud.x[i]));
+        max_dev = fmax(max_dev,fabs(ref.y[i] - cloud.y[i]));
+        max_dev = fmax(max_dev,fabs(ref.z[i] - cloud.z[i]));
+    }
+    return max_dev;
+}
+
+//frames of the room scene through the driver, converted by the consumer after newData()
+//or by the recv thread as the packets arrive. reports the work left to the consumer at the
+//frame cut and the whole throughput
+//usage: velo_driver_calib_bench [calib_file] [frame_num]
+int main(int argc, char ** argv)
+{
+    char default_file[128] = "../S3735.xml";
+    char * calib_file = argc > 1 ? argv[1] : default_file;
+    unsigned int frame_num = argc > 2 ? atoi(argv[2]) : 50;
+    VeloCalib calib(calib_file);
+    if(!calib.valid())
+    {
+        return -1;
+    }
+
+    //stp1. the packets of frame_num revolutions in memory
+    GeneratorConfig generator_config;
+    VeloGenerator::defaultConfig(generator_config);
+    generator_config.scene = SCENE_ROOM;
+    VeloGenerator generator(&generator_config);
+    unsigned int packet_num = (unsigned int)(60e6 / generator_config.rpm / generator.packetPeriod()) * frame_num;
+    char * packets = new char[(size_t)packet_num * PACKET_SIZE];
+    for(unsigned int i = 0; i < packet_num; i++)
+    {
+        generator.buildPacket((unsigned char *)packets + (size_t)i * PACKET_SIZE);
+    }
+    unsigned int max_block_num = frameBlockNum(generator_config.laser_num,generator_config.rpm);
+    CloudXYZI_ptr cloud = createCloudXYZI(max_block_num * 32);
+    printf("LOG:%u packets, %u frames\n",packet_num,frame_num);
+
+    //stp2. the consumer converts, then the recv thread converts, then the same checked
+    //against the conversion of the whole frame
+    const char * names[3] = {"convert after newData","convert on recv thread","check"};
+    for(int mode = 0; mode < 3; mode++)
+    {
+        MemorySource source(packets,packet_num);
+        DriverConfig driver_config;
+        VeloDriver::defaultConfig(driver_config);
+        driver_config.batch_num = 32;
+        driver_config.drop_policy = QUEUE_BLOCK;
+        driver_config.calib = mode >= 1 ? &calib : nullptr;
+        unsigned int taken_num = 0;
+        unsigned long long point_num = 0;
+        double cut_work = 0;
+        double max_dev = 0;
+        double start_time = nowSecond();
+        {
+            VeloDriver velo_driver(&source,&driver_config);
+            while(velo_driver.newData())
+            {
+                double take_time = nowSecond();
+                CloudXYZI * frame_cloud = velo_driver.raw_data->cloud;
+                if(frame_cloud == nullptr)
+                {
+                    calib.convFrame(velo_driver.raw_data,*cloud);
+                    frame_cloud = cloud;
+                }
+                cut_work += nowSecond() - take_time;
+                point_num += frame_cloud->point_num;
+                taken_num ++;
+                if(mode == 2)
+                {
+                    calib.convFrame(velo_driver.raw_data,*cloud);
+                    max_dev = fmax(max_dev,maxDeviation(*cloud,*frame_cloud));
+                }
+            }
+        }
+        double elapsed = nowSecond() - start_time;
+        if(mode == 2)
+        {
+            printf("LOG:%-24s %u frames, max deviation %.3g cm against convFrame\n",names[mode],taken_num,max_dev);
+            continue;
+        }
+        printf("LOG:%-24s %u frames, %llu points, work after the cut %8.3f ms/frame, %7.1f frames/s\n",
+               names[mode],taken_num,point_num,cut_work * 1e3 / taken_num,taken_num / elapsed);
+    }
+
+    freeCloudXYZI(cloud);
+    delete [] packets;
+    return 0;
+}
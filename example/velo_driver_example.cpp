@@ -1,4 +1,5 @@
 #include "velo_driver.h"
+#include "velo_frame.h"
 #include <iostream>
 #include <time.h>
 using namespace std;
@@ -7,16 +8,34 @@ int main()
 {
     char device_ip[128] = "192.168.2.201";
     unsigned int data_port = 2368;
-    VeloDriver velo64_driver(device_ip,data_port);
+    DriverConfig driver_config;
+    VeloDriver::defaultConfig(driver_config);
+    driver_config.batch_num = 32;
+    driver_config.rpm = 600;
+    VeloDriver velo64_driver(device_ip,data_port,&driver_config);
+    DriverStats stats;
+    CompactFrame_ptr compact = nullptr;
     char save_file_dir[128];
     while(velo64_driver.newData())
     {
+        //dump the compact layout, only the received blocks are written
         sprintf(save_file_dir,"../data/%06u.bin",velo64_driver.raw_data->frame_id);
+        //as large as the frames of the sensor the driver found
+        if(compact == nullptr)
+        {
+            compact = createCompactFrame(velo64_driver.raw_data->max_block_num);
+        }
+        frameToCompact(velo64_driver.raw_data,compact);
         FILE * fp = fopen(save_file_dir,"wb");
-        fwrite(velo64_driver.raw_data,sizeof(FrameData),1,fp);
-        fclose(fp);
-        printf("LOG:frame %u time:%lu  size:%u\n",velo64_driver.raw_data->frame_id,clock()/1000,velo64_driver.raw_data->block_num);
+        if(fp != nullptr)
+        {
+            saveCompactFrame(fp,compact);
+            fclose(fp);
+        }
+        velo64_driver.getStats(stats);
+        printf("LOG:frame %u time:%lu  size:%u  packets/syscall:%.2f\n",velo64_driver.raw_data->frame_id,clock()/1000,velo64_driver.raw_data->block_num,
+               (double)stats.recv_packets / (double)(stats.poll_calls + stats.recv_calls + 1));
     }
+    freeCompactFrame(compact);
     return 0;
 }
-
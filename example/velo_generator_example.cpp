@@ -0,0 +1,173 @@
+#include "velo_generator.h"
+#include <iostream>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+using namespace std;
+
+#define PACKET_SIZE 1206
+#define MAX_SENSOR  16
+#define SEND_BATCH  64
+
+static double nowSecond()
+{
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC,&now);
+    return now.tv_sec + now.tv_nsec * 1e-9;
+}
+
+//send synthetic data packets of several simulated sensors over UDP,
+//sensor i goes to base_port + i
+//usage: velo_generator_example [sensor_num] [rpm] [scene 0:ring 1:ground 2:room] [laser_num]
+//                              [seconds] [speed, 0 as fast as possible] [ip] [base_port]
+int main(int argc, char ** argv)
+{
+    int sensor_num = argc > 1 ? atoi(argv[1]) : 1;
+    unsigned int rpm = argc > 2 ? atoi(argv[2]) : 600;
+    int scene = argc > 3 ? atoi(argv[3]) : SCENE_ROOM;
+    int laser_num = argc > 4 ? atoi(argv[4]) : 64;
+    double seconds = argc > 5 ? atof(argv[5]) : 10.0;
+    double speed = argc > 6 ? atof(argv[6]) : 1.0;
+    const char * ip = argc > 7 ? argv[7] : "127.0.0.1";
+    unsigned int base_port = argc > 8 ? atoi(argv[8]) : 2368;
+    if(sensor_num < 1 || sensor_num > MAX_SENSOR)
+    {
+        printf("ERRO:sensor_num should be 1-%d\n",MAX_SENSOR);
+        return 1;
+    }
+
+    //stp1. one generator and one destination per sensor
+    VeloGenerator * generators[MAX_SENSOR];
+    sockaddr_in dest_addrs[MAX_SENSOR];
+    unsigned long long sent_num[MAX_SENSOR];
+    for(int i = 0; i < sensor_num; i++)
+    {
+        GeneratorConfig generator_config;
+        VeloGenerator::defaultConfig(generator_config);
+        generator_config.laser_num = laser_num;
+        generator_config.rpm = rpm;
+        generator_config.scene = scene;
+        generator_config.start_angle = 36000 / sensor_num * i;
+        generators[i] = new VeloGenerator(&generator_config);
+        memset(&dest_addrs[i],0,sizeof(sockaddr_in));
+        dest_addrs[i].sin_family = AF_INET;
+        dest_addrs[i].sin_port = htons(base_port + i);
+        inet_aton(ip,&dest_addrs[i].sin_addr);
+        sent_num[i] = 0;
+    }
+    int sock_fd = socket(PF_INET,SOCK_DGRAM,0);
+    if(sock_fd < 0)
+    {
+        perror("socket");
+        return 1;
+    }
+
+    //stp2. packet ring of every sensor for sendmmsg(), packets [pend_begin,pend_begin + pend_num)
+    //of it are built but not sent yet
+    static char packet_ring[MAX_SENSOR][SEND_BATCH][PACKET_SIZE];
+    static mmsghdr msgs[MAX_SENSOR][SEND_BATCH];
+    static iovec iovs[MAX_SENSOR][SEND_BATCH];
+    int pend_begin[MAX_SENSOR];
+    int pend_num[MAX_SENSOR];
+    memset(msgs,0,sizeof(msgs));
+    for(int i = 0; i < sensor_num; i++)
+    {
+        for(int j = 0; j < SEND_BATCH; j++)
+        {
+            iovs[i][j].iov_base = packet_ring[i][j];
+            iovs[i][j].iov_len = PACKET_SIZE;
+            msgs[i][j].msg_hdr.msg_iov = &iovs[i][j];
+            msgs[i][j].msg_hdr.msg_iovlen = 1;
+            msgs[i][j].msg_hdr.msg_name = &dest_addrs[i];
+            msgs[i][j].msg_hdr.msg_namelen = sizeof(sockaddr_in);
+        }
+        pend_begin[i] = 0;
+        pend_num[i] = 0;
+    }
+
+    //stp3. send what is due for every sensor, then sleep a little
+    double packet_rate = 1e6 / generators[0]->packetPeriod() * speed;
+    if(speed > 0)
+    {
+        printf("LOG:%d sensors, %d lasers, %u rpm, %.0f packets/s per sensor\n",sensor_num,laser_num,rpm,packet_rate);
+    }
+    else
+    {
+        printf("LOG:%d sensors, %d lasers, %u rpm, unthrottled\n",sensor_num,laser_num,rpm);
+    }
+    double start_time = nowSecond();
+    double report_time = start_time;
+    unsigned long long report_num = 0;
+    unsigned long long send_calls = 0;
+    unsigned long long send_fails = 0;
+    while(true)
+    {
+        double now_time = nowSecond();
+        double elapsed = now_time - start_time;
+        if(elapsed >= seconds)
+        {
+            break;
+        }
+        for(int i = 0; i < sensor_num; i++)
+        {
+            unsigned long long due_num = speed > 0 ? (unsigned long long)(elapsed * packet_rate) : sent_num[i] + SEND_BATCH;
+            while(sent_num[i] < due_num)
+            {
+                //a new batch only once the last one is on the wire, the generator has moved past it
+                if(pend_num[i] == 0)
+                {
+                    pend_begin[i] = 0;
+                    pend_num[i] = due_num - sent_num[i] < SEND_BATCH ? (int)(due_num - sent_num[i]) : SEND_BATCH;
+                    for(int j = 0; j < pend_num[i]; j++)
+                    {
+                        generators[i]->buildPacket((unsigned char *)packet_ring[i][j]);
+                    }
+                }
+                int ret = sendmmsg(sock_fd,msgs[i] + pend_begin[i],pend_num[i],0);
+                send_calls ++;
+                if(ret <= 0)
+                {
+                    //nothing sent, the batch is tried again on the next round
+                    send_fails += ret < 0;
+                    break;
+                }
+                pend_begin[i] += ret;
+                pend_num[i] -= ret;
+                sent_num[i] += ret;
+            }
+        }
+        if(now_time - report_time >= 1.0)
+        {
+            unsigned long long total_num = 0;
+            for(int i = 0; i < sensor_num; i++)
+            {
+                total_num += sent_num[i];
+            }
+            double rate = (total_num - report_num) / (now_time - report_time);
+            printf("LOG:%.0f packets/s (%.1f Mbit/s), %.0f per sensor\n",rate,rate * PACKET_SIZE * 8 / 1e6,rate / sensor_num);
+            report_time = now_time;
+            report_num = total_num;
+        }
+        if(speed > 0)
+        {
+            usleep(500);
+        }
+    }
+
+    //stp4. achieved rate over the whole run
+    double elapsed = nowSecond() - start_time;
+    unsigned long long total_num = 0;
+    for(int i = 0; i < sensor_num; i++)
+    {
+        total_num += sent_num[i];
+        delete generators[i];
+    }
+    printf("LOG:sent %llu packets in %.3f s: %.0f packets/s, %.2f packets/syscall, %llu failed sends\n",
+           total_num,elapsed,total_num / elapsed,(double)total_num / (send_calls > 0 ? send_calls : 1),send_fails);
+    close(sock_fd);
+    return 0;
+}
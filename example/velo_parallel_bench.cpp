@@ -0,0 +1,134 @@
+#include "velo_calib.h"
+#include "velo_frame.h"
+#include "velo_generator.h"
+#include "thread_pool.h"
+#include "common.h"
+#include <iostream>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+using namespace std;
+
+static double nowSecond()
+{
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC,&now);
+    return now.tv_sec + now.tv_nsec * 1e-9;
+}
+
+//1 when both clouds hold the same points in the same order
+template <typename Real>
+static int sameCloud(const CloudXYZIT<Real> & ref, const CloudXYZIT<Real> & cloud)
+{
+    if(ref.point_num != cloud.point_num)
+    {
+        return 0;
+    }
+    size_t n = ref.point_num;
+    return memcmp(ref.x,cloud.x,n * sizeof(Real)) == 0 && memcmp(ref.y,cloud.y,n * sizeof(Real)) == 0 &&
+           memcmp(ref.z,cloud.z,n * sizeof(Real)) == 0 && memcmp(ref.intensity,cloud.intensity,n) == 0 &&
+           memcmp(ref.line_id,cloud.line_id,n) == 0;
+}
+
+//points/s of one frame layout and precision for every thread number, the serial convFrame first
+template <typename Real, typename Frame>
+static void scaling(const char * name, VeloCalibT<Real> & calib, const Frame * frame, unsigned int raw_num,
+                    int max_thread_num, int affinity, int loop_num)
+{
+    CloudXYZIT<Real> * ref = new CloudXYZIT<Real>;
+    CloudXYZIT<Real> * cloud = new CloudXYZIT<Real>;
+    CloudXYZIT<Real> * clouds[2] = {ref,cloud};
+    for(int i = 0; i < 2; i++)
+    {
+        clouds[i]->point_num = 0;
+        clouds[i]->max_point_num = raw_num;
+        clouds[i]->x = new Real[raw_num];
+        clouds[i]->y = new Real[raw_num];
+        clouds[i]->z = new Real[raw_num];
+        clouds[i]->intensity = new unsigned char[raw_num];
+        clouds[i]->line_id = new unsigned char[raw_num];
+    }
+    double start_time = nowSecond();
+    for(int l = 0; l < loop_num; l++)
+    {
+        calib.convFrame(frame,*ref);
+    }
+    double serial_rate = (double)raw_num * loop_num / (nowSecond() - start_time);
+    printf("LOG:%-20s serial     %12.0f points/s\n",name,serial_rate);
+    for(int thread_num = 1; thread_num <= max_thread_num; thread_num++)
+    {
+        PoolConfig pool_config;
+        ThreadPool::defaultConfig(pool_config);
+        pool_config.thread_num = thread_num;
+        pool_config.affinity = affinity;
+        ThreadPool pool(&pool_config);
+        calib.convFrame(frame,*cloud,pool);
+        start_time = nowSecond();
+        for(int l = 0; l < loop_num; l++)
+        {
+            calib.convFrame(frame,*cloud,pool);
+        }
+        double rate = (double)raw_num * loop_num / (nowSecond() - start_time);
+        printf("LOG:%-20s %2d threads %12.0f points/s  x%.2f of serial, %llu tasks stolen, %s\n",name,thread_num,rate,
+               rate / serial_rate,pool.getStealNum(),sameCloud(*ref,*cloud) ? "same points" : "DIFFERENT points");
+    }
+    for(int i = 0; i < 2; i++)
+    {
+        delete [] clouds[i]->x;
+        delete [] clouds[i]->y;
+        delete [] clouds[i]->z;
+        delete [] clouds[i]->intensity;
+        delete [] clouds[i]->line_id;
+        delete clouds[i];
+    }
+}
+
+//scaling of the frame conversion on a work stealing pool from 1 to max_thread_num workers,
+//one 64E frame of the room scene
+//usage: velo_parallel_bench [calib_file] [max_thread_num] [affinity] [loop_num]
+int main(int argc, char ** argv)
+{
+    char default_file[128] = "../S3735.xml";
+    char * calib_file = argc > 1 ? argv[1] : default_file;
+    int cpu_num = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    int max_thread_num = argc > 2 ? atoi(argv[2]) : (cpu_num > 4 ? cpu_num : 4);
+    int affinity = argc > 3 ? atoi(argv[3]) : 1;
+    int loop_num = argc > 4 ? atoi(argv[4]) : 100;
+    VeloCalib calib(calib_file);
+    VeloCalibF calib_f(calib_file);
+    if(!calib.valid() || !calib_f.valid())
+    {
+        return -1;
+    }
+
+    //stp1. one revolution of the room scene in both frame layouts
+    GeneratorConfig generator_config;
+    VeloGenerator::defaultConfig(generator_config);
+    generator_config.scene = SCENE_ROOM;
+    VeloGenerator generator(&generator_config);
+    unsigned int max_block_num = frameBlockNum(64,generator_config.rpm);
+    unsigned int packet_num = (unsigned int)(60e6 / generator_config.rpm / generator.packetPeriod());
+    CompactFrame_ptr compact = createCompactFrame(max_block_num);
+    FrameData_ptr frame = createFrameData(max_block_num);
+    VeloDecoder decoder;
+    unsigned char packet[1206];
+    for(unsigned int i = 0; i < packet_num; i++)
+    {
+        generator.buildPacket(packet);
+        appendPacket(decoder,packet,compact);
+    }
+    compactToFrame(compact,frame);
+    unsigned int raw_num = compact->block_num * 32;
+    printf("LOG:%d online cpus, %u blocks, %u raw points per frame\n",cpu_num,compact->block_num,raw_num);
+
+    //stp2. every layout and precision
+    scaling("double CompactFrame",calib,compact,raw_num,max_thread_num,affinity,loop_num);
+    scaling("double FrameData",calib,frame,raw_num,max_thread_num,affinity,loop_num);
+    scaling("float CompactFrame",calib_f,compact,raw_num,max_thread_num,affinity,loop_num);
+
+    freeFrameData(frame);
+    freeCompactFrame(compact);
+    return 0;
+}
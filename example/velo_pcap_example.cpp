@@ -0,0 +1,44 @@
+#include "velo_driver.h"
+#include <iostream>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+using namespace std;
+
+//replay a capture and report the throughput of the frame assembly
+//usage: velo_pcap_example file.pcap [data_port] [realtime]
+int main(int argc, char ** argv)
+{
+    if(argc < 2)
+    {
+        printf("usage: %s file.pcap [data_port] [realtime]\n",argv[0]);
+        return 1;
+    }
+    unsigned int data_port = argc > 2 ? atoi(argv[2]) : 2368;
+    DriverConfig driver_config;
+    VeloDriver::defaultConfig(driver_config);
+    driver_config.pcap_file = argv[1];
+    driver_config.batch_num = 64;
+    driver_config.replay_mode = (argc > 3 && strcmp(argv[3],"realtime") == 0) ? REPLAY_REALTIME : REPLAY_MAX_SPEED;
+    //without pacing the consumer must not lose frames
+    driver_config.drop_policy = QUEUE_BLOCK;
+
+    timespec start_time,end_time;
+    clock_gettime(CLOCK_MONOTONIC,&start_time);
+    VeloDriver velo64_driver(nullptr,data_port,&driver_config);
+    unsigned long long frame_num = 0;
+    unsigned long long block_num = 0;
+    while(velo64_driver.newData())
+    {
+        frame_num ++;
+        block_num += velo64_driver.raw_data->block_num;
+    }
+    clock_gettime(CLOCK_MONOTONIC,&end_time);
+    double elapsed = (end_time.tv_sec - start_time.tv_sec) + (end_time.tv_nsec - start_time.tv_nsec) * 1e-9;
+
+    DriverStats stats;
+    velo64_driver.getStats(stats);
+    printf("LOG:%llu packets, %llu frames, %llu blocks in %.3f s, %llu blocks overflowed\n",stats.recv_packets,frame_num,block_num,elapsed,stats.overflow_blocks);
+    printf("LOG:%.0f packets/s, %.1f frames/s\n",stats.recv_packets / elapsed,frame_num / elapsed);
+    return 0;
+}
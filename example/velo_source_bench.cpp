@@ -0,0 +1,93 @@
+#include "velo_driver.h"
+#include "pcap_reader.h"
+#include <iostream>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+using namespace std;
+
+static double nowSecond()
+{
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC,&now);
+    return now.tv_sec + now.tv_nsec * 1e-9;
+}
+
+//run the frame assembly over one source until it ends
+static void runSource(const char * name, PacketSource * source)
+{
+    DriverConfig driver_config;
+    VeloDriver::defaultConfig(driver_config);
+    driver_config.batch_num = 64;
+    driver_config.drop_policy = QUEUE_BLOCK;
+    double start_time = nowSecond();
+    unsigned long long frame_num = 0;
+    DriverStats stats;
+    {
+        VeloDriver velo_driver(source,&driver_config);
+        while(velo_driver.newData())
+        {
+            frame_num ++;
+        }
+        velo_driver.getStats(stats);
+    }
+    double elapsed = nowSecond() - start_time;
+    printf("LOG:%-10s %llu packets, %llu frames in %.3f s: %.0f packets/s, %.1f frames/s\n",
+           name,stats.recv_packets,frame_num,elapsed,stats.recv_packets / elapsed,frame_num / elapsed);
+}
+
+//frame assembly throughput without the network stack
+//usage: velo_source_bench [file.pcap] [data_port]
+int main(int argc, char ** argv)
+{
+    const unsigned int packet_num = 200000;
+
+    //1.synthetic packets built on the fly
+    GeneratorSource generator_source(64,600,packet_num);
+    runSource("generator",&generator_source);
+
+    //2.packets already in memory, from a capture or from the generator
+    char * packets = new char[(size_t)packet_num * PACKET_SIZE];
+    unsigned int memory_num = 0;
+    if(argc > 1)
+    {
+        PcapReader reader(argv[1],argc > 2 ? atoi(argv[2]) : 2368);
+        const unsigned char * payload;
+        int len;
+        double time_stamp;
+        while(memory_num < packet_num && reader.nextPacket(&payload,&len,&time_stamp))
+        {
+            if(len == PACKET_SIZE)
+            {
+                memcpy(packets + (size_t)memory_num * PACKET_SIZE,payload,PACKET_SIZE);
+                memory_num ++;
+            }
+        }
+    }
+    else
+    {
+        GeneratorSource fill_source(64,600,packet_num);
+        const char * batch[64];
+        int lens[64];
+        int npackets;
+        while((npackets = fill_source.nextPackets(batch,lens,64)) > 0)
+        {
+            for(int i = 0; i < npackets; i++)
+            {
+                memcpy(packets + (size_t)memory_num * PACKET_SIZE,batch[i],PACKET_SIZE);
+                memory_num ++;
+            }
+        }
+    }
+    MemorySource memory_source(packets,memory_num,packet_num / (memory_num > 0 ? memory_num : 1));
+    runSource("memory",&memory_source);
+
+    //3.the capture itself
+    if(argc > 1)
+    {
+        PcapSource pcap_source(argv[1],nullptr,argc > 2 ? atoi(argv[2]) : 2368,REPLAY_MAX_SPEED);
+        runSource("pcap",&pcap_source);
+    }
+    delete [] packets;
+    return 0;
+}
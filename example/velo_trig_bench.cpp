@@ -0,0 +1,151 @@
+#include "velo_calib.h"
+#include "velo_frame.h"
+#include "velo_generator.h"
+#include "common.h"
+#include <iostream>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+using namespace std;
+
+#define CACHE_LINE 64
+#define EVICT_SIZE (32 << 20)
+
+static double nowSecond()
+{
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC,&now);
+    return now.tv_sec + now.tv_nsec * 1e-9;
+}
+
+//largest coordinate gap (cm) between two clouds of the same points
+static double maxDeviation(const CloudXYZI & ref, const CloudXYZI & cloud)
+{
+    if(ref.point_num != cloud.point_num)
+    {
+        return HUGE_VAL;
+    }
+    double max_dev = 0;
+    for(unsigned int i = 0; i < ref.point_num; i++)
+    {
+        max_dev = fmax(max_dev,fabs(ref.x[i] - cloud.x[i]));
+        max_dev = fmax(max_dev,fabs(ref.y[i] - cloud.y[i]));
+        max_dev = fmax(max_dev,fabs(ref.z[i] - cloud.z[i]));
+    }
+    return max_dev;
+}
+
+//cache lines of the fused trig table read by one frame, cos and sin of every point
+static size_t touchedLines(const TrigTable & trig, const CompactFrame & compact)
+{
+    size_t entry_size = trig.format == TRIG_TABLE_FLOAT ? sizeof(float) : sizeof(short);
+    size_t line_num = ((size_t)trig.column_num * 2 * LASER_NUM * entry_size + CACHE_LINE - 1) / CACHE_LINE;
+    unsigned char * touched = new unsigned char[line_num];
+    memset(touched,0,line_num);
+    size_t touched_num = 0;
+    for(unsigned int i = 0; i < compact.block_num; i++)
+    {
+        int column = (compact.rot_angle[i] + trig.azimuth_step / 2) / trig.azimuth_step % trig.column_num;
+        int line_base = compact.upper_or_lower[i] == 0xDDFF ? 32 : 0;
+        for(int k = 0; k < 32; k++)
+        {
+            if(compact.distance[i][k] == 0)
+            {
+                continue;
+            }
+            size_t index = (size_t)column * 2 * LASER_NUM + line_base + k;
+            size_t lines[2] = {index * entry_size / CACHE_LINE,(index + LASER_NUM) * entry_size / CACHE_LINE};
+            for(int j = 0; j < 2; j++)
+            {
+                touched_num += touched[lines[j]] == 0;
+                touched[lines[j]] = 1;
+            }
+        }
+    }
+    delete [] touched;
+    return touched_num;
+}
+
+//points/s of the azimuth tables (on the fly) and the fused laser x azimuth trig tables,
+//warm: the same frame again and again; cold: the caches are flushed before every frame
+//usage: velo_trig_bench [calib_file] [loop_num]
+int main(int argc, char ** argv)
+{
+    char default_file[128] = "../S3735.xml";
+    char * calib_file = argc > 1 ? argv[1] : default_file;
+    int loop_num = argc > 2 ? atoi(argv[2]) : 50;
+    VeloCalib * calib = new VeloCalib(calib_file);
+    unsigned char * evict = new unsigned char[EVICT_SIZE];
+    memset(evict,1,EVICT_SIZE);
+    //volatile keeps the eviction pass from being optimised out
+    volatile unsigned long long evict_sum = 0;
+
+    const int formats[5] = {TRIG_TABLE_OFF,TRIG_TABLE_FLOAT,TRIG_TABLE_INT16,TRIG_TABLE_FLOAT,TRIG_TABLE_INT16};
+    const int steps[5] = {1,1,1,10,10};
+    const char * names[5] = {"on the fly","fused float 0.01 deg","fused int16 0.01 deg","fused float 0.1 deg","fused int16 0.1 deg"};
+    const int laser_nums[2] = {32,64};
+    for(int l_index = 0; l_index < 2; l_index++)
+    {
+        //stp1. one revolution of the room scene
+        GeneratorConfig generator_config;
+        VeloGenerator::defaultConfig(generator_config);
+        generator_config.scene = SCENE_ROOM;
+        generator_config.laser_num = laser_nums[l_index];
+        VeloGenerator generator(&generator_config);
+        unsigned int max_block_num = frameBlockNum(generator_config.laser_num,generator_config.rpm);
+        unsigned int packet_num = (unsigned int)(60e6 / generator_config.rpm / generator.packetPeriod());
+        CompactFrame_ptr compact = createCompactFrame(max_block_num);
+        VeloDecoder decoder;
+        unsigned char packet[1206];
+        for(unsigned int i = 0; i < packet_num; i++)
+        {
+            generator.buildPacket(packet);
+            appendPacket(decoder,packet,compact);
+        }
+        unsigned int raw_num = compact->block_num * 32;
+        CloudXYZI_ptr ref = createCloudXYZI(raw_num);
+        CloudXYZI_ptr cloud = createCloudXYZI(raw_num);
+        printf("LOG:%d lasers, %u blocks, %u raw points per frame\n",laser_nums[l_index],compact->block_num,raw_num);
+
+        //stp2. every table mode, batch conversion of the CompactFrame
+        for(int mode = 0; mode < 5; mode++)
+        {
+            long bytes = calib->setTrigTable(formats[mode],steps[mode]);
+            size_t touched = formats[mode] == TRIG_TABLE_OFF ? 0 : touchedLines(calib->getTrigTable(),*compact);
+            double start_time = nowSecond();
+            for(int l = 0; l < loop_num; l++)
+            {
+                calib->convFrame(compact,*cloud);
+            }
+            double warm_rate = (double)raw_num * loop_num / (nowSecond() - start_time);
+            double cold_time = 0;
+            for(int l = 0; l < loop_num; l++)
+            {
+                for(int i = 0; i < EVICT_SIZE; i += CACHE_LINE)
+                {
+                    evict[i] ++;
+                    evict_sum += evict[i];
+                }
+                start_time = nowSecond();
+                calib->convFrame(compact,*cloud);
+                cold_time += nowSecond() - start_time;
+            }
+            double cold_rate = (double)raw_num * loop_num / cold_time;
+            if(mode == 0)
+            {
+                calib->convFrame(compact,*ref);
+            }
+            printf("LOG:  %-22s table %8.1f KB, touched %8.1f KB/frame  warm %11.0f  cold %11.0f points/s  max deviation %.3g cm\n",
+                   names[mode],bytes / 1024.0,touched * CACHE_LINE / 1024.0,warm_rate,cold_rate,maxDeviation(*ref,*cloud));
+        }
+        calib->setTrigTable(TRIG_TABLE_OFF);
+        freeCloudXYZI(ref);
+        freeCloudXYZI(cloud);
+        freeCompactFrame(compact);
+    }
+
+    delete [] evict;
+    delete calib;
+    return 0;
+}
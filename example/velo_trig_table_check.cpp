@@ -0,0 +1,38 @@
+#include "velo_trig_table.h"
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+//entries of the generated table that differ bit for bit from the libm values
+template <typename Real>
+static int countMismatch(const VeloTrigTable<Real> & table)
+{
+    int mismatch = 0;
+    for(int i = 0; i < AZIMUTH_NUM; i++)
+    {
+        double angle = veloAzimuthRadian(i);
+        Real cos_value = cos(angle);
+        Real sin_value = sin(angle);
+        mismatch += memcmp(&cos_value,&table.cos_rot_table[i],sizeof(Real)) != 0;
+        mismatch += memcmp(&sin_value,&table.sin_rot_table[i],sizeof(Real)) != 0;
+        mismatch += veloQ15(cos(angle)) != table.cos_rot_table_q15[i];
+        mismatch += veloQ15(sin(angle)) != table.sin_rot_table_q15[i];
+    }
+    return mismatch;
+}
+
+//the tables generated at build time against the ones createTable() computed at runtime
+//usage: velo_trig_table_check, returns 1 on any difference
+int main()
+{
+    int mismatch_double = countMismatch(velo_trig_table_double);
+    int mismatch_float = countMismatch(velo_trig_table_float);
+    printf("LOG:double tables %d, float tables %d mismatches of %d entries each\n",
+           mismatch_double,mismatch_float,4 * AZIMUTH_NUM);
+    if(mismatch_double != 0 || mismatch_float != 0)
+    {
+        printf("ERRO:the generated tables differ from libm\n");
+        return 1;
+    }
+    return 0;
+}
@@ -1,5 +1,5 @@
 /**
-* commom structure and defines for 32E and 64E
+* commom structure and defines for VLP-16, 32E and 64E
 * last modified: 2018.6.5
 *
 * Zhenbo Song(songzb@njust.edu.cn)
@@ -9,11 +9,14 @@
 #define __COMMON_H__
 
 //depend on lidar type and rotation RPM.
-//MAX_BLOCK_NUM = MAX_LINE_POINT * LASER_NUM / 32
-//MAX_LINE_POINT = 2500 *  600 / RPM
-//TODO: write these number into configure file; adapt the 16 vlp lidar.
+//MAX_BLOCK_NUM = line points * LASER_NUM / 32, line points = 2500 *  600 / RPM
+//frame buffers and line clouds are sized at runtime by frameBlockNum() and
+//frameLinePointNum() in velo_frame.h, MAX_BLOCK_NUM is only what it gives
+//for the 64E at 600 RPM.
+//a block holds 32 returns for every model: the 32 lasers of a 64E upper or lower
+//block or of a 32E firing, or two firings of the 16 lasers of a VLP-16.
+//LASER_NUM is the most lines of these, the 64E, the others use the first lines.
 #define  MAX_BLOCK_NUM       5000
-#define  MAX_LINE_POINT      2500
 #define  LASER_NUM           64
 
 //Math use
@@ -38,16 +41,27 @@ typedef struct tagBlock
     unsigned short block_id;
     unsigned short rot_angle;
     Laser fire_laser[32];
+    //firing time of the block, us past the hour, see blockTimeStampe() and blockTimeStampeT()
     unsigned int gps_time_stampe;
     unsigned char gps_status_type;
     unsigned char gps_status_value;
 }Block,*Block_ptr;
 
+template <typename Real> struct CloudXYZIT;
+
 typedef struct tagFrameData
 {
     unsigned int frame_id;
     unsigned int block_num;
-    Block frame_block[MAX_BLOCK_NUM];
+    //sector streaming: index of this sector in the frame, 1 for the sector ending the frame
+    unsigned short sector_id;
+    unsigned short last_sector;
+    //capacity of frame_block, see createFrameData()
+    unsigned int max_block_num;
+    Block_ptr frame_block;
+    //points of frame_block converted by the driver as the packets arrive,
+    //nullptr when the driver has no calibration, see DriverConfig
+    CloudXYZIT<double> * cloud;
 }FrameData,*FrameData_ptr;
 
 //
@@ -59,6 +73,15 @@ typedef struct tagPoint3FI
     unsigned char   intensity;
 }Point3FI,*Point3FI_ptr;
 
+//single precision of Point3FI, see VeloCalibT<float>
+typedef struct tagPoint3FIf
+{
+    float x;
+    float y;
+    float z;
+    unsigned char   intensity;
+}Point3FIf,*Point3FIf_ptr;
+
 typedef struct  tagPoint3II
 {
     int x;
@@ -93,6 +116,13 @@ typedef struct tagPoint3F
     double z;
 }Point3F,*Point3F_ptr;
 
+typedef struct tagPoint3Ff
+{
+    float x;
+    float y;
+    float z;
+}Point3Ff,*Point3Ff_ptr;
+
 
 typedef struct tagPoint3FIT
 {
@@ -120,24 +150,63 @@ typedef struct tagPointLRDI
     unsigned char  intensity;
 }PointLRDI,*PointLRDI_ptr;
 
+//the lines hold max_line_point points each, see createOriginData()
 typedef struct tagOriginData
 {
-    PointLRDI  line_point[LASER_NUM][MAX_LINE_POINT];
+    PointLRDI * line_point[LASER_NUM];
     int line_point_num[LASER_NUM];
+    int max_line_point;
 }OriginData,*OriginData_ptr;
 
+//the lines hold max_line_point points each, see createPointCloud()
 typedef struct tagPointCloud
 {
-    Point3II line_point_cloud[LASER_NUM][MAX_LINE_POINT];
+    Point3II * line_point_cloud[LASER_NUM];
     int line_point_num[LASER_NUM];
-
+    int max_line_point;
 }PointCloud,*PointCloud_ptr;
 
 
 
 #pragma pack(pop)
 
-
+//compact frame, structure of arrays: 16 bit distances, 8 bit intensities and
+//per block values in their own arrays, 107 bytes per block instead of 172.
+//the arrays hold max_block_num entries, see createCompactFrame()
+typedef struct tagCompactFrame
+{
+    unsigned int frame_id;
+    unsigned int block_num;
+    unsigned short sector_id;
+    unsigned short last_sector;
+    unsigned int max_block_num;
+    unsigned short (*distance)[32];
+    unsigned char  (*intensity)[32];
+    unsigned short * upper_or_lower;
+    unsigned short * rot_angle;
+    unsigned int   * gps_time_stampe;
+    unsigned char  * block_id;
+    unsigned char  * gps_status_type;
+    unsigned char  * gps_status_value;
+}CompactFrame,*CompactFrame_ptr;
+
+//point cloud, structure of arrays in cm, only the points [0,point_num) with a
+//distance are kept. the arrays hold max_point_num entries, see createCloudXYZI()
+template <typename Real>
+struct CloudXYZIT
+{
+    unsigned int point_num;
+    unsigned int max_point_num;
+    Real * x;
+    Real * y;
+    Real * z;
+    unsigned char * intensity;
+    unsigned char * line_id;
+};
+typedef CloudXYZIT<double> CloudXYZI;
+typedef CloudXYZI * CloudXYZI_ptr;
+typedef CloudXYZIT<float> CloudXYZIf;
+typedef CloudXYZIf * CloudXYZIf_ptr;
 
 
 
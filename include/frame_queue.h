@@ -0,0 +1,45 @@
+/**
+* Bounded lock-free frame queue between the recv thread and the consumer
+* last modified: 2018.6.5
+*
+* Zhenbo Song(songzb@njust.edu.cn)
+*
+* illustration:
+* one thread pushes, pop() may be called from both sides: the consumer takes
+* frames in order, the producer takes the oldest one back when dropping it.
+* Indices increase monotonically and pop() claims a slot with a CAS on head.
+*/
+#ifndef __FRAME_QUEUE_H__
+#define __FRAME_QUEUE_H__
+
+#include <atomic>
+#include "common.h"
+
+class FrameQueue
+{
+public:
+    //Constructor and destructor
+    FrameQueue(unsigned int capacity);
+    ~FrameQueue();
+
+    //API,member functions
+    //1.append a frame at the tail, single producer, false if full
+    bool push(FrameData_ptr frame);
+    //2.take the frame at the head, nullptr if empty
+    FrameData_ptr pop();
+    //3.number of queued frames
+    unsigned int size();
+    bool empty(){return size() == 0;}
+    bool full(){return size() >= cap;}
+
+private:
+    //member variables
+    //1.ring of frame pointers
+    std::atomic<FrameData_ptr> * slots;
+    unsigned int cap;
+    //2.monotonic read and write index
+    std::atomic<unsigned long long> head;
+    std::atomic<unsigned long long> tail;
+};
+
+#endif
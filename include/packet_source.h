@@ -0,0 +1,139 @@
+/**
+* Packet sources feeding the Velodyne frame assembly
+* last modified: 2018.6.5
+*
+* Zhenbo Song(songzb@njust.edu.cn)
+*
+* illustration:
+* the driver asks a source for batches of raw data packets and does not care
+* where they come from:
+*   UdpSource        live device, poll() + recvfrom() or recvmmsg() batches
+*   PcapSource       memory-mapped capture, real-time paced or as fast as possible
+*   MemorySource     packets already in memory, replayed loop_num times
+*   GeneratorSource  synthetic packets, no network or file involved
+*/
+#ifndef __PACKET_SOURCE_H__
+#define __PACKET_SOURCE_H__
+
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <atomic>
+#include "pcap_reader.h"
+#include "velo_generator.h"
+
+//fix number ,no need of modifying
+#define PACKET_SIZE    1206
+#define PACKET_BUF_SIZE 2048
+
+class PacketSource
+{
+public:
+    PacketSource(){poll_calls = 0; recv_calls = 0;}
+    virtual ~PacketSource(){}
+
+    //API,member functions
+    //1.read up to max_num packets, packets[i] stays valid until the next call
+    //  @return number of packets; 0: nothing arrived in time; -1: end of the source or error
+    virtual int nextPackets(const char ** packets, int * lens, int max_num) = 0;
+    //2.syscalls spent waiting for and reading packets
+    unsigned long long getPollCalls(){return poll_calls;}
+    unsigned long long getRecvCalls(){return recv_calls;}
+
+protected:
+    std::atomic<unsigned long long> poll_calls;
+    std::atomic<unsigned long long> recv_calls;
+};
+
+class UdpSource : public PacketSource
+{
+public:
+    //Constructor and destructor
+    //batch_num > 1 drains up to batch_num datagrams by one recvmmsg() per wakeup
+    UdpSource(const char * device_ip, const unsigned int data_port, const unsigned int batch_num = 1);
+    ~UdpSource();
+
+    int nextPackets(const char ** packets, int * lens, int max_num);
+
+private:
+    //member variables
+    //1.socket id
+    int sock_fd;
+    in_addr dev_ip;
+    //2.preallocated packet ring and headers for recvmmsg()
+    unsigned int ring_num;
+    char * packet_ring;
+    struct mmsghdr * ring_msgs;
+    struct iovec * ring_iovs;
+    sockaddr_in * ring_addrs;
+
+    //member functions
+    //1.start communication with device
+    void startComm(const char * device_ip,const unsigned int data_port);
+    //2.wait until the socket is readable, 0: readable, 1: error, 2: timeout
+    int pollSocket();
+};
+
+enum
+{
+    REPLAY_REALTIME = 0,
+    REPLAY_MAX_SPEED
+};
+
+class PcapSource : public PacketSource
+{
+public:
+    //Constructor and destructor
+    //device_ip keeps packets from this IP only, nullptr for any
+    PcapSource(const char * pcap_file, const char * device_ip, const unsigned int data_port, int replay_mode = REPLAY_REALTIME);
+    ~PcapSource(){}
+
+    int nextPackets(const char ** packets, int * lens, int max_num);
+    int isOpen(){return reader.isOpen();}
+
+private:
+    PcapReader reader;
+    in_addr dev_ip;
+    int mode;
+    //pcap time of the first replayed packet and the wall clock at that moment
+    double replay_stamp;
+    double replay_clock;
+};
+
+class MemorySource : public PacketSource
+{
+public:
+    //packet_num packets of PACKET_SIZE bytes back to back, not copied
+    MemorySource(const char * packets, const unsigned int packet_num, const unsigned int loop_num = 1);
+    ~MemorySource(){}
+
+    int nextPackets(const char ** packets, int * lens, int max_num);
+
+private:
+    const char * data;
+    unsigned int data_num;
+    unsigned int loop_left;
+    unsigned int index;
+};
+
+class GeneratorSource : public PacketSource
+{
+public:
+    //packet_num synthetic packets, 0 for an endless source
+    GeneratorSource(const unsigned int laser_num, const unsigned int rpm, const unsigned long long packet_num, const int scene = SCENE_RING);
+    GeneratorSource(const GeneratorConfig * generator_config, const unsigned long long packet_num);
+    ~GeneratorSource();
+
+    int nextPackets(const char ** packets, int * lens, int max_num);
+
+private:
+    VeloGenerator * generator;
+    unsigned long long packet_left;
+    bool endless;
+    unsigned int ring_num;
+    char * packet_ring;
+
+    void variableInit(const GeneratorConfig * generator_config, const unsigned long long packet_num);
+};
+
+#endif
@@ -0,0 +1,59 @@
+/**
+* Memory-mapped reader for classic pcap captures of Velodyne traffic
+* last modified: 2018.6.5
+*
+* Zhenbo Song(songzb@njust.edu.cn)
+*
+* illustration:
+* stp1（map the capture): PcapReader(const char * file_dir, unsigned int data_port);
+* stp2（walk the udp payloads sent to data_port): while(nextPacket(&data,&len,&stamp)) analyse(data,len);
+* stp3（start over）: rewind();
+* Supported link layers: ethernet (with 802.1Q tags), linux cooked, raw ip and bsd loopback.
+*/
+#ifndef __PCAP_READER_H__
+#define __PCAP_READER_H__
+
+#include <stddef.h>
+
+class PcapReader
+{
+public:
+    //Constructor and destructor
+    PcapReader(const char * file_dir, const unsigned int data_port);
+    ~PcapReader();
+
+    //API,member functions
+    //1.whether the file is mapped and has a valid pcap header
+    int isOpen(){return file_data != nullptr;}
+    //2.next udp payload sent to data_port, pointing into the mapped file
+    //  @return 1: ok; 0: end of the capture
+    int nextPacket(const unsigned char ** payload, int * len, double * time_stamp, unsigned int * src_ip = nullptr);
+    //3.go back to the first packet
+    void rewind();
+    //4.return the last packet again on the next call
+    void stepBack(){file_offset = last_offset;}
+
+private:
+    //member variables
+    //1.mapped capture file
+    const unsigned char * file_data;
+    size_t file_size;
+    size_t file_offset;
+    size_t last_offset;
+    //2.global header values
+    bool swap_order;
+    bool nano_stamp;
+    unsigned int link_type;
+    //3.udp destination port to keep
+    unsigned int port;
+
+    //member functions
+    //1.read the global header
+    int readHeader();
+    //2.4 bytes in file byte order
+    unsigned int readU32(const unsigned char * p);
+    //3.offset of the ip header inside one frame, -1 if not ip
+    int ipOffset(const unsigned char * frame, int len);
+};
+
+#endif
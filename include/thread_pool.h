@@ -0,0 +1,92 @@
+/**
+* Work stealing thread pool for the frame conversions
+* last modified: 2018.6.5
+*
+* Zhenbo Song(songzb@njust.edu.cn)
+*
+* illustration:
+* stp1（start the workers once): ThreadPool(PoolConfig * pool_config);
+* stp2（run task_num tasks, each worker starts on its own share of them and steals
+*       half of the tasks left to another worker when its share is done）: run(task_num,func,arg);
+*/
+#ifndef __THREAD_POOL_H__
+#define __THREAD_POOL_H__
+
+#include <thread>
+#include <atomic>
+#include <pthread.h>
+
+/** Configure inparameter：
+*   thread_num ( workers including the thread calling run(), 0 for every online cpu )
+*   affinity ( pin the pool threads, worker i to cpu (first_cpu + i) % cpu number,
+*              the calling thread (worker 0) is left as it is )
+*   first_cpu ( offset of the cpus of workers 1 to thread_num - 1, worker 0 is not pinned,
+*               pin the calling thread to first_cpu to keep the workers on their own cpus )
+*/
+typedef struct tagPoolConfig
+{
+    int thread_num;
+    int affinity;
+    int first_cpu;
+}PoolConfig,*PoolConfig_ptr;
+
+//task function, task in [0,task_num) and worker in [0,thread_num)
+typedef void (*PoolTask)(void * arg, int task, int worker);
+
+class ThreadPool
+{
+public:
+    //Constructor and destructor
+    ThreadPool(const PoolConfig * pool_config = nullptr);
+    ~ThreadPool();
+
+    //API,member function
+    //1.run func for every task, returns when all of them are done. not reentrant
+    void run(int task_num, PoolTask func, void * arg);
+    //2.number of workers
+    int getThreadNum(){return thread_num;}
+    //3.tasks a worker took from the share of another one during the last run
+    unsigned long long getStealNum(){return steal_num;}
+    //4.fill the configure with default values
+    static void defaultConfig(PoolConfig & pool_config);
+
+private:
+    //member variables
+    //1.configures and the pool threads, workers 1 to thread_num - 1
+    PoolConfig config;
+    int thread_num;
+    std::thread * threads;
+    //2.tasks left to each worker, begin << 32 | end, cache line apart.
+    //the owner takes from the begin, the thieves from the end
+    struct alignas(64) TaskRange
+    {
+        std::atomic<unsigned long long> range;
+    };
+    TaskRange * ranges;
+    //3.the run in progress, a new generation wakes the workers
+    PoolTask task_func;
+    void * task_arg;
+    unsigned int generation;
+    int busy_num;
+    bool stop;
+    pthread_mutex_t pool_lock;
+    pthread_cond_t  start_signal;
+    pthread_cond_t  done_signal;
+    std::atomic<unsigned long long> steal_num;
+
+    //member functions
+    //1.Init all variables
+    void variableInit(const PoolConfig * pool_config);
+    //2.Free all variables
+    void variableFree();
+    //3.run the own tasks then steal until every share is empty
+    void work(int worker);
+    //4.take the next own task, -1 when the share is empty
+    int popTask(int worker);
+    //5.move half of the tasks of another worker into the own share, false when all are empty
+    bool stealTask(int worker);
+    //6.pool thread function
+    static void workerThread(ThreadPool * pool, int worker);
+};
+
+#endif
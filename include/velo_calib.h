@@ -9,10 +9,11 @@
 *
 */
 
-#ifndef __VELO_CLIB_H__
+#ifndef __VELO_CALIB_H__
 #define __VELO_CALIB_H__
 
 #include "common.h"
+#include "thread_pool.h"
 
 #pragma pack(push)
 #pragma pack(1)
@@ -41,47 +42,430 @@ typedef struct tagLaserCorrection {
 
 #pragma pack(pop)
 
+//rigid transform of the sensor into the vehicle frame: p' = rotation * p + translation (cm)
+typedef struct tagExtrinsic
+{
+    double rotation[3][3];
+    double translation[3];
+}Extrinsic,*Extrinsic_ptr;
+
+//per laser coefficients compiled from in_param by createTable(), one 64 bytes
+//aligned array per term so the vector kernels load 4 (double) or 8 (float)
+//lasers at a time. with r the raw distance (2mm):
+//  xy distance = r * xy_scale + xy_offset, z = r * z_scale + z_offset
+//  two points correction = two_pt_slope * |x or y| + two_pt_offset
+//the extrinsic transform of the sensor is kept with them, rows of rotation | translation
+template <typename Real>
+struct LaserCoeffT
+{
+    Real cos_rot_correction[LASER_NUM];
+    Real sin_rot_correction[LASER_NUM];
+    Real horiz_offset_correction[LASER_NUM];
+    Real xy_scale[LASER_NUM];
+    Real xy_offset[LASER_NUM];
+    Real z_scale[LASER_NUM];
+    Real z_offset[LASER_NUM];
+    Real cos_vert_correction[LASER_NUM];
+    Real sin_vert_correction[LASER_NUM];
+    Real two_pt_slope_x[LASER_NUM];
+    Real two_pt_offset_x[LASER_NUM];
+    Real two_pt_slope_y[LASER_NUM];
+    Real two_pt_offset_y[LASER_NUM];
+    Real two_pt_correction_available[LASER_NUM];  ///< 1 or 0
+    Real focal_offset[LASER_NUM];                 ///< 256 * (1 - focal_distance / 13100)^2
+    Real focal_slope[LASER_NUM];
+    Real min_intensity[LASER_NUM];
+    Real max_intensity[LASER_NUM];
+    Real extrinsic[12];
+    int extrinsic_available;                      ///< 0 for the identity
+    Real region[6];                               ///< kept box of CalibFilter, x y z min and max
+    Real body[6];                                 ///< rejected box of CalibFilter
+    int region_available;
+    int body_available;
+};
+typedef LaserCoeffT<double> LaserCoeff;
+typedef LaserCoeff * LaserCoeff_ptr;
+
+//per laser coefficients of the fixed point conversion, for an output unit of
+//1/unit cm the lanes work in 1/(16 * unit) cm:
+//  xy distance = ((r >> 8) * xy_scale + ((r & 255) * xy_scale >> 8) + xy_offset) >> 8, z likewise
+//  trig corrections in Q15, focal offset in Q10, focal slope in Q14
+//  extrinsic rotation in Q15 and translation in lanes
+//  boxes of CalibFilter in the output unit
+typedef struct tagLaserCoeffInt
+{
+    int cos_rot_correction[LASER_NUM];
+    int sin_rot_correction[LASER_NUM];
+    int horiz_offset_correction[LASER_NUM];
+    int xy_scale[LASER_NUM];
+    int xy_offset[LASER_NUM];
+    int z_scale[LASER_NUM];
+    int z_offset[LASER_NUM];
+    int focal_offset[LASER_NUM];
+    int focal_slope[LASER_NUM];
+    int min_intensity[LASER_NUM];
+    int max_intensity[LASER_NUM];
+    int extrinsic[12];
+    int extrinsic_available;
+    int region_available;
+    int body_available;
+    int reserved[1];                ///< 64 bytes multiple, int_coeff is an array
+    int region[6];
+    int body[6];
+    int reserved_box[4];
+}LaserCoeffInt,*LaserCoeffInt_ptr;
+
+//unit of the integer points, per cm
+enum
+{
+    INT_UNIT_CM = 1,
+    INT_UNIT_MM = 10
+};
+
+//format of the fused laser x azimuth trig table, see VeloCalibT::setTrigTable()
+enum
+{
+    TRIG_TABLE_OFF = 0,     //azimuth tables and the rot_correction multiplies
+    TRIG_TABLE_FLOAT,
+    TRIG_TABLE_INT16        //Q15
+};
+
+//cos and sin of (azimuth - rot_correction) per laser, one column every azimuth_step
+//(0.01 degree), a column holds the cos of all lasers then the sin of all lasers
+typedef struct tagTrigTable
+{
+    int format;
+    int azimuth_step;
+    int column_num;
+    void * table;
+}TrigTable,*TrigTable_ptr;
+
+//instruction set of the batch conversions
+enum
+{
+    CALIB_AUTO = -1,
+    CALIB_SCALAR = 0,
+    CALIB_AVX2          //AVX2 and FMA
+};
+
+#define FILTER_SECTOR_MAX 8
+
+/** rules of the early rejection in the frame conversions, see VeloCalibT::setFilter()
+*  Configure inparameter：
+*   min_distance,max_distance ( kept raw distance (2mm) before dist_correction, inclusive )
+*   sector_num,sector_start,sector_end ( kept azimuth sectors (0.01 degree) of the raw rot_angle,
+*                                       [start,end), wrapping over 0 when end < start. 0 sector keeps all )
+*   laser_mask ( kept line ids, bit i for line id i )
+*   region_enable,region ( kept box in the output frame (cm), x_min,x_max,y_min,y_max,z_min,z_max )
+*   body_enable,body ( rejected box in the output frame (cm), the ego vehicle, same order )
+*/
+typedef struct tagCalibFilter
+{
+    unsigned short min_distance;
+    unsigned short max_distance;
+    int sector_num;
+    unsigned short sector_start[FILTER_SECTOR_MAX];
+    unsigned short sector_end[FILTER_SECTOR_MAX];
+    unsigned long long laser_mask;
+    int region_enable;
+    double region[6];
+    int body_enable;
+    double body[6];
+}CalibFilter,*CalibFilter_ptr;
+
+//rules of CalibFilter in the order they are checked, index of FilterCount::rejected
+enum
+{
+    FILTER_SECTOR = 0,
+    FILTER_LASER,
+    FILTER_DISTANCE,
+    FILTER_REGION,
+    FILTER_BODY,
+    FILTER_RULE_NUM
+};
+
+//points rejected by each rule, a point is counted by the first rule rejecting it.
+//points without distance are not counted
+typedef struct tagFilterCount
+{
+    unsigned long long rejected[FILTER_RULE_NUM];
+}FilterCount,*FilterCount_ptr;
+
+/** organized range image of a frame, see VeloCalibT::convFrame()
+*   row r holds the line id row_line[r], the lasers sorted by vert_correction from the bottom,
+*   column c the raw rot_angle in [c * azimuth_step, (c + 1) * azimuth_step) (0.01 degree).
+*   every plane holds row_num * column_num cells column by column, cell (r,c) at c * row_num + r,
+*   so the lasers of a block are written next to each other.
+*   range (cm, along the beam after dist_correction) is 0 in a cell without a point,
+*   the other planes of such a cell are left as they were
+*/
+template <typename Real>
+struct RangeImageT
+{
+    int row_num;
+    int column_num;
+    int azimuth_step;
+    unsigned int point_num;                 ///< cells holding a point
+    unsigned char row_line[LASER_NUM];
+    Real * range;
+    Real * x;
+    Real * y;
+    Real * z;
+    unsigned char * intensity;
+};
+typedef RangeImageT<double> RangeImage;
+typedef RangeImage * RangeImage_ptr;
+typedef RangeImageT<float> RangeImagef;
+typedef RangeImagef * RangeImagef_ptr;
+
+/** pose of the vehicle in the odometry frame at one time, see VeloCalibT::setDeskew()
+*  Configure inparameter：
+*   time ( us past the hour, the clock of gps_time_stampe )
+*   position ( m )
+*   rpy ( roll, pitch, yaw, degree, R = Rz(yaw) * Ry(pitch) * Rx(roll) )
+*/
+typedef struct tagEgoPose
+{
+    unsigned int time;
+    double position[3];
+    double rpy[3];
+}EgoPose,*EgoPose_ptr;
+
+//motion between two ego poses in the vehicle frame at the reference time of the de-skew,
+//pose(start + a * duration) = rotation * (I + sin(a * angle) * axis + (1 - cos(a * angle)) * axis2)
+//and translation + a * velocity, a beyond [0,1] extrapolates
+typedef struct tagDeskewSegment
+{
+    double start;                   ///< us from the reference time
+    double duration;
+    double rotation[9];
+    double axis[9];                 ///< skew matrix of the unit rotation axis
+    double axis2[9];                ///< axis * axis
+    double angle;                   ///< radian
+    double translation[3];          ///< cm
+    double velocity[3];             ///< cm per segment
+}DeskewSegment,*DeskewSegment_ptr;
+
 //fix number ,no need of modifying
 #define DISTANCE_RESOLUTION 0.2f
 
-class VeloCalib
+//allocate a cloud of max_point_num points, free with freeCloudXYZI()
+CloudXYZI_ptr createCloudXYZI(unsigned int max_point_num);
+CloudXYZIf_ptr createCloudXYZIf(unsigned int max_point_num);
+void freeCloudXYZI(CloudXYZI_ptr cloud);
+void freeCloudXYZI(CloudXYZIf_ptr cloud);
+//allocate a range image of 36000 / azimuth_step columns, nullptr when azimuth_step does not divide 36000
+RangeImage_ptr createRangeImage(int azimuth_step);
+RangeImagef_ptr createRangeImagef(int azimuth_step);
+void freeRangeImage(RangeImage_ptr image);
+void freeRangeImage(RangeImagef_ptr image);
+
+//output point of each precision
+template <typename Real> struct CalibPoint;
+template <> struct CalibPoint<double> {typedef Point3FI Type;};
+template <> struct CalibPoint<float> {typedef Point3FIf Type;};
+
+/** precision of tables, coefficients and output：
+*   VeloCalib ( double, Point3FI and CloudXYZI )
+*   VeloCalibF ( float, Point3FIf and CloudXYZIf, twice the vector width and half
+*                the memory of the tables and clouds, see velo_calib_bench for the accuracy )
+*  Configure inparameter：
+*   calib_file_dir ( db.xml of the sensor )
+*   cache_file_dir ( binary cache of the parsed xml, nullptr for none. it is mapped read
+*                    only when it matches the xml and rewritten from the xml otherwise )
+*   print_param ( print every field of every laser while parsing the xml )
+*/
+template <typename Real>
+class VeloCalibT
 {
 public:
+    typedef typename CalibPoint<Real>::Type Point;
+    typedef CloudXYZIT<Real> Cloud;
+    typedef RangeImageT<Real> Image;
+
     //Constructor and destructor
-    VeloCalib(char * calib_file_dir);
-    ~VeloCalib();
+    VeloCalibT(char * calib_file_dir, const char * cache_file_dir = nullptr, bool print_param = false);
+    ~VeloCalibT();
 
     //API,member function
     //1.converse raw point into 3D point
-    int convLRDI2XYZI(PointLRDI_ptr input_PointLRDI,Point3FI & output_Point3FI);
+    int convLRDI2XYZI(PointLRDI_ptr input_PointLRDI,Point & output_Point3FI);
+    //  the same from the packed in_param, kept as the reference of the other conversions
+    int convLRDI2XYZIRef(PointLRDI_ptr input_PointLRDI,Point & output_Point3FI);
     //2.get the x'th top laser scan
     int getTopXLaser(int n){return (int)scan_table[LASER_NUM-n].x;}
     //3.get gap between the n1'th top and the n2'th top
     double getGapXYLaser(int up,int down){return (scan_table[up-1].y-scan_table[down-1].y);}
+    //4.converse a whole frame into the cloud, points without distance are left out.
+    //line id is the laser in the block, + 32 for the lower block (0xDDFF).
+    //blocks that do not fit into the cloud are dropped.
+    //@return number of points in the cloud
+    int convFrame(const FrameData * frame, Cloud & cloud);
+    int convFrame(const CompactFrame * compact, Cloud & cloud);
+    //  the same for block_num blocks appended to the cloud, for a frame converted while it arrives
+    int convBlocks(const Block * block, unsigned int block_num, Cloud & cloud);
+    //  the same on the workers of a pool: the blocks are split into chunks of chunk_block_num,
+    //  each chunk is written to its own part of the cloud, no locks. points beyond max_point_num
+    //  are dropped. one frame at a time per VeloCalibT, the scratch is kept for the next one
+    int convFrame(const FrameData * frame, Cloud & cloud, ThreadPool & pool, int chunk_block_num = 64);
+    int convFrame(const CompactFrame * compact, Cloud & cloud, ThreadPool & pool, int chunk_block_num = 64);
+    //5.converse num raw points given as arrays, appended to the cloud
+    //@return number of points in the cloud
+    int convLRDI2XYZI(const unsigned char * line_id, const unsigned short * rot_angle,
+                      const unsigned short * distance, const unsigned char * intensity,
+                      int num, Cloud & cloud);
+    //6.fixed point conversions into integer points of 1/unit cm (INT_UNIT_CM or INT_UNIT_MM)
+    //with Q15 trig tables, the error grows with range to about 8 mm at 131 m.
+    //@return 0: distance is 0; 1: ok
+    int convLRDI2XYZII(PointLRDI_ptr input_PointLRDI,Point3II & output_Point3II,int unit = INT_UNIT_CM);
+    //frames go straight into line_point_cloud[line], which must be cleared by the caller, points past
+    //max_line_point of a line are dropped without notice, size the cloud with frameLinePointNum()
+    //@return number of points in the lines of the cloud
+    int convFrame(const FrameData * frame, PointCloud & cloud, int unit = INT_UNIT_CM);
+    int convFrame(const CompactFrame * compact, PointCloud & cloud, int unit = INT_UNIT_CM);
+    //7.pick the instruction set of 4. 5. and 6., CALIB_AUTO takes the best one the cpu supports
+    //@return the level in use
+    int setLevel(int level);
+    int getLevel(){return conv_level;}
+    //8.fused trig table of 1. 4. and 5., a lookup per point instead of the azimuth tables and
+    //the rot_correction multiplies. azimuth_step must divide 36000, the azimuth is rounded to
+    //the nearest column; TRIG_TABLE_OFF goes back to the azimuth tables.
+    //the fixed point conversions of 6. are not affected.
+    //@return bytes of the table, -1 on a bad format or step
+    long setTrigTable(int format, int azimuth_step = 1);
+    const TrigTable & getTrigTable(){return trig_table;}
+    //9.extrinsic transform applied by 1. 4. 5. and 6. (not by convLRDI2XYZIRef), read from
+    //position_ (xyz, m) and orientation_ (rpy, degree, R = Rz(yaw) * Ry(pitch) * Rx(roll))
+    //of the xml, or overridden by a 4x4 matrix with the translation in cm.
+    //nullptr goes back to the one of the xml
+    //@return 1: points are transformed; 0: the transform is the identity
+    int setExtrinsic(const double matrix[4][4]);
+    const Extrinsic & getExtrinsic(){return extrinsic;}
+    //10.early rejection of 4. 5. and 6. (not of the single point conversions). sector, laser and
+    //distance are checked on the raw data before any math, region and body on the point in the
+    //output frame (after the extrinsic) before the intensity and the store.
+    //nullptr turns it off, defaultFilter() keeps every point
+    //@return 1: some rule is on; 0: off; -1: bad sectors, the filter is left as it was
+    int setFilter(const CalibFilter * filter);
+    const CalibFilter & getFilter(){return filter;}
+    static void defaultFilter(CalibFilter & filter);
+    //  rejections since the construction or the last reset
+    const FilterCount & getFilterCount(){return filter_count;}
+    void resetFilterCount(){filter_count = FilterCount();}
+    //11.organized range image of a frame, see RangeImageT. the points of 4. with the filter and
+    //the extrinsic, neighbours are a row or a column apart. blocks of the same column overwrite
+    //each other, the later one is kept
+    //@return number of cells holding a point
+    int convFrame(const FrameData * frame, Image & image);
+    int convFrame(const CompactFrame * compact, Image & image);
+    //12.motion de-skew of 4. and 11.: the points of a block are moved with the ego pose at its
+    //gps_time_stampe into the vehicle frame at ref_time, p' = pose(ref_time)^-1 * pose(time) * extrinsic * p,
+    //inside the conversion. the poses are interpolated, or extrapolated from the first or the last two,
+    //they are copied and need increasing times. nullptr turns it off
+    //@return 1: on; 0: off; -1: less than 2 poses or times not increasing, the de-skew is left as it was
+    int setDeskew(const EgoPose * poses, int pose_num, unsigned int ref_time);
+    //13.the calibration file or its cache was read. when it was not the conversions still run,
+    //with every correction 0
+    bool valid(){return calib_valid;}
 
 private:
     //member variables
     //1.lidar calibration file
     LaserCorrection in_param[LASER_NUM];
-    //2.tables for calculating
-    double cos_rot_table[36000];
-    double sin_rot_table[36000];
+    //2.tables for calculating, constant data generated at build time, see velo_trig_table.h
+    const Real * cos_rot_table;
+    const Real * sin_rot_table;
     //3.laser scanning sorting table, bottom to top
     Point2F scan_table[LASER_NUM];
+    //4.in_param compiled into per laser coefficients
+    LaserCoeffT<Real> * laser_coeff;
+    //5.instruction set of the batch conversions
+    int conv_level;
+    //6.fixed point tables, Q15 azimuth trig and the coefficients for cm [0] and mm [1],
+    //lasers with the two points correction take the floating point path
+    const short * cos_rot_table_q15;
+    const short * sin_rot_table_q15;
+    LaserCoeffInt_ptr int_coeff;
+    bool two_pt_any;
+    //7.fused trig table, see setTrigTable()
+    TrigTable trig_table;
+    //8.print every field while parsing the xml
+    bool print_param;
+    //9.extrinsic of the xml and the one in use
+    Extrinsic xml_extrinsic;
+    Extrinsic extrinsic;
+    //10.early rejection, raw data rules of it on and the counters
+    CalibFilter filter;
+    bool filter_raw;
+    FilterCount filter_count;
+    //11.conversions on a thread pool, see convFramePool(). scratch points of every chunk at
+    //chunk_block_num * 32 apart and the heads of the chunks, points kept by each chunk and in its
+    //head, where they go in the cloud and the rejections of each chunk
+    Cloud * chunk_cloud;
+    Cloud * chunk_head;
+    unsigned int * chunk_point_num;
+    unsigned int * chunk_head_num;
+    unsigned int * chunk_offset;
+    FilterCount * chunk_count;
+    unsigned int chunk_capacity;
+    //  the frame in progress, converted straight into job_cloud or through chunk_cloud
+    bool job_direct;
+    const Block * job_block;
+    const CompactFrame * job_compact;
+    unsigned int job_block_num;
+    int job_chunk_block_num;
+    Cloud * job_cloud;
+    //12.motion de-skew, segments between the poses
+    DeskewSegment * deskew_segment;
+    int deskew_segment_num;
+    unsigned int deskew_ref_time;
+    //13.the calibration file or its cache was read
+    bool calib_valid;
 
     //member functions
     //1.Init all variables
-    void variableInit(){}
+    void variableInit();
     //2.Free all variables
-    void variableFree(){}
-    //3.create calculate tables
+    void variableFree();
+    //3.point 2. and 6. at the generated tables, compile the per laser coefficients
     void createTable();
+    void createCoeff();
+    void createExtrinsic();
+    void createFilter();
     //4.read calibration file
     int readFile(char * file_dir);
     //5.sort the scanning laser from bottom to top
     void quickSort(Point2F *s, int l, int r);
+    //6.map the binary cache, 0 when it is missing, broken or older than the xml
+    int loadCache(const char * calib_file_dir, const char * cache_file_dir);
+    int saveCache(const char * calib_file_dir, const char * cache_file_dir);
+    //7.converse the 32 lasers of one block, transformed by extrinsic (rows of rotation | translation,
+    //nullptr for none)
+    int convPoint(PointLRDI_ptr input_PointLRDI, Point & output_Point3FI, const Real * extrinsic);
+    void convBlock(const unsigned short * distance, const unsigned char * intensity, unsigned short upper_or_lower,
+                   unsigned short rot_angle, const Real * extrinsic, Cloud & cloud, FilterCount & count);
+    void convBlock(const unsigned short * distance, const unsigned char * intensity,
+                   unsigned short upper_or_lower, unsigned short rot_angle, PointCloud & cloud, int unit);
+    //  blocks [begin,end) of a FrameData (block_data) or of a CompactFrame (block_data = nullptr)
+    void convRange(const Block * block_data, const CompactFrame * compact, unsigned int begin,
+                   unsigned int end, Cloud & cloud, FilterCount & count);
+    //8.frame conversions on a thread pool, tasks of the workers: count, converse and pack a chunk
+    int convFramePool(const Block * block_data, const CompactFrame * compact, unsigned int block_num,
+                      Cloud & cloud, ThreadPool & pool, int chunk_block_num);
+    static void countChunkTask(void * arg, int task, int worker);
+    static void convChunkTask(void * arg, int task, int worker);
+    static void packChunkTask(void * arg, int task, int worker);
+    //9.blocks of a FrameData (block_data) or of a CompactFrame (block_data = nullptr) into the cells
+    //of a range image
+    void convImage(const Block * block_data, const CompactFrame * compact, unsigned int block_num, Image & image);
+    //10.transform of the blocks fired at time_stampe: the extrinsic, or with the de-skew the one made
+    //in extrinsic_buf, kept with buf_time (~0U for none yet) for the next block of the same firing
+    const Real * blockExtrinsic(unsigned int time_stampe, Real * extrinsic_buf, unsigned int & buf_time);
 };
 
+typedef VeloCalibT<double> VeloCalib;
+typedef VeloCalibT<float> VeloCalibF;
+
 
 
 #endif
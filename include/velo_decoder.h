@@ -0,0 +1,148 @@
+/**
+* Vectorized Velodyne data packet decoder
+* last modified: 2018.6.5
+*
+* Zhenbo Song(songzb@njust.edu.cn)
+*
+* illustration:
+* deinterleaves the 12 x 32 (distance, intensity) triplets of one packet into
+* separate distance and intensity rows (structure of arrays), with SSE4.1 or
+* AVX2 byte shuffles when the cpu has them and a scalar loop otherwise.
+* stp1（pick the instruction set): VeloDecoder decoder;
+* stp2（decode every packet）: decoder.decode(packet,decoded_packet);
+* The 12 x 32 triplets are laid out alike for every model, what the rows mean
+* (lasers, firing times, returns) is given by SensorTraits of the model found
+* by detectSensor().
+*/
+#ifndef __VELO_DECODER_H__
+#define __VELO_DECODER_H__
+
+//one packet in structure of arrays, rows of 32 lasers per block
+typedef struct tagDecodedPacket
+{
+    unsigned short distance[12][32];
+    unsigned char  intensity[12][32];
+    unsigned short upper_or_lower[12];
+    unsigned short rot_angle[12];
+    unsigned int   gps_time_stampe;
+    unsigned char  gps_status_type;
+    unsigned char  gps_status_value;
+}DecodedPacket,*DecodedPacket_ptr;
+
+enum
+{
+    DECODER_AUTO = -1,
+    DECODER_SCALAR = 0,
+    DECODER_SSE41,
+    DECODER_AVX2
+};
+
+//sensor models of the packets, see detectSensor()
+enum
+{
+    MODEL_UNKNOWN = -1,
+    MODEL_HDL64E = 0,       //upper (0xEEFF) and lower (0xDDFF) blocks fired together
+    MODEL_HDL32E,           //upper blocks only
+    MODEL_VLP16,            //two firings of 16 lasers in every block
+    MODEL_NUM
+};
+
+//return mode of the packets. with dual return the blocks of a firing come twice,
+//the last return first, then the strongest one
+enum
+{
+    RETURN_STRONGEST = 0,
+    RETURN_LAST,
+    RETURN_DUAL,
+    RETURN_MODE_NUM
+};
+
+typedef struct tagSensorInfo
+{
+    int model;
+    int return_mode;
+}SensorInfo,*SensorInfo_ptr;
+
+/** packet layout of every model, at compile time in SensorTraits and at run time in SensorLayout
+*   laser_num ( lasers of the sensor )
+*   block_per_firing ( blocks fired together, an upper and a lower one for the 64E )
+*   firing_per_block ( firings held by one block, two firings of 16 lasers for the VLP-16 )
+*   firing_period ( us from a firing to the next one )
+*   block_rate ( blocks per second in single return mode )
+*/
+template <int Model> struct SensorTraits;
+template <> struct SensorTraits<MODEL_HDL64E>
+{
+    static constexpr int laser_num = 64;
+    static constexpr int block_per_firing = 2;
+    static constexpr int firing_per_block = 1;
+    static constexpr double firing_period = 48.0;
+    static constexpr unsigned int block_rate = 41664;
+};
+template <> struct SensorTraits<MODEL_HDL32E>
+{
+    static constexpr int laser_num = 32;
+    static constexpr int block_per_firing = 1;
+    static constexpr int firing_per_block = 1;
+    static constexpr double firing_period = 46.08;
+    static constexpr unsigned int block_rate = 21696;
+};
+template <> struct SensorTraits<MODEL_VLP16>
+{
+    static constexpr int laser_num = 16;
+    static constexpr int block_per_firing = 1;
+    static constexpr int firing_per_block = 2;
+    static constexpr double firing_period = 55.296;
+    static constexpr unsigned int block_rate = 9048;
+};
+
+typedef struct tagSensorLayout
+{
+    int laser_num;
+    int block_per_firing;
+    int firing_per_block;
+    double firing_period;
+    unsigned int block_rate;
+}SensorLayout,*SensorLayout_ptr;
+
+//layout of a model, the 64E for MODEL_UNKNOWN
+const SensorLayout & sensorLayout(int model);
+
+//model and return mode of a packet: the 32E and the VLP-16 give them in the factory bytes
+//(return mode at 1204, product id at 1205), the 64E keeps its gps status there and is told by
+//its lower blocks, its dual return by the first two blocks sharing the header and the azimuth.
+//a packet of upper blocks without factory bytes is taken as a 32E of an older firmware
+//@return 1: known; 0: block headers of none of these models, model is MODEL_UNKNOWN
+int detectSensor(const unsigned char * packet, SensorInfo & info);
+
+//decode the lasers of block_num blocks starting at packet, writing one row per block
+typedef void (*DecodeBlocksFunc)(const unsigned char * packet, int block_num,
+                                 unsigned short (*distance)[32], unsigned char (*intensity)[32],
+                                 unsigned short * upper_or_lower, unsigned short * rot_angle);
+
+class VeloDecoder
+{
+public:
+    //Constructor and destructor
+    //level DECODER_AUTO takes the best one the cpu supports
+    VeloDecoder(int level = DECODER_AUTO);
+    ~VeloDecoder(){}
+
+    //API,member functions
+    //1.decode one PACKET_SIZE bytes packet
+    void decode(const unsigned char * packet, DecodedPacket & decoded_packet);
+    //2.decode the 12 blocks of one packet into rows of an existing structure of arrays
+    void decodeBlocks(const unsigned char * packet, unsigned short (*distance)[32], unsigned char (*intensity)[32],
+                      unsigned short * upper_or_lower, unsigned short * rot_angle)
+    {decode_func(packet,12,distance,intensity,upper_or_lower,rot_angle);}
+    //3.instruction set in use
+    int getLevel(){return level_in_use;}
+    //4.best instruction set of this cpu
+    static int cpuLevel();
+
+private:
+    int level_in_use;
+    DecodeBlocksFunc decode_func;
+};
+
+#endif
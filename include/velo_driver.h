@@ -1,5 +1,5 @@
 /**
-* Velodyne lidar Driver for 32E and 64E
+* Velodyne lidar Driver for VLP-16, 32E and 64E
 * last modified: 2018.6.1
 *
 * Zhenbo Song(songzb@njust.edu.cn)
@@ -11,63 +11,190 @@
 #ifndef __VELO_DRIVER_H__
 #define __VELO_DRIVER_H__
 
-#include <netinet/in.h>
 #include <thread>
+#include <atomic>
 #include <pthread.h>
 #include "common.h"
+#include "frame_queue.h"
+#include "packet_source.h"
+#include "velo_calib.h"
+#include "velo_decoder.h"
 
-//fix number ,no need of modifying
-#define PACKET_SIZE    1206
+/** Configure inparameter：
+*   batch_num ( max packets asked from the source at once, for the socket the datagrams
+*               drained by one recvmmsg() per wakeup, 1 uses poll()+recvfrom() )
+*   queue_depth ( finished frames waiting for the consumer, the pool holds queue_depth + 2 buffers )
+*   drop_policy ( what a frame cut does when the queue is full, see QUEUE_DROP_OLDEST ... )
+*   cut_angle ( 100 * degree where a frame starts and ends, 0-35999 )
+*   sector_angle ( 100 * degree, publish a partial frame every sector_angle from cut_angle on, 0 off )
+*   sector_packets ( publish a partial frame every sector_packets packets, 0 off )
+*   pcap_file ( replay this capture instead of opening the socket, nullptr for the live device )
+*   replay_mode ( REPLAY_REALTIME paces packets by their pcap time stamps, REPLAY_MAX_SPEED does not wait )
+*   laser_num ( 0 finds the model in the first packet with detectSensor(), 16, 32 or 64 sets it.
+*               the model, the return mode of the packets and rpm size the frame buffers,
+*               see frameBlockNum() )
+*   rpm ( rotation speed the sensor is set to, slower spins need larger frames )
+*   calib ( convert the blocks of every packet into raw_data->cloud on the recv thread as they
+*           arrive, so the cloud is finished at the frame cut. nullptr keeps the raw blocks only.
+*           kept by the caller and not changed (setLevel, setFilter ...) while the driver runs )
+*/
+typedef struct tagDriverConfig
+{
+    unsigned int batch_num;
+    unsigned int queue_depth;
+    int drop_policy;
+    unsigned int cut_angle;
+    unsigned int sector_angle;
+    unsigned int sector_packets;
+    const char * pcap_file;
+    int replay_mode;
+    int laser_num;
+    unsigned int rpm;
+    VeloCalib * calib;
+}DriverConfig,*DriverConfig_ptr;
+
+enum
+{
+    QUEUE_DROP_OLDEST = 0,  //overwrite the oldest queued frame
+    QUEUE_DROP_NEWEST,      //discard the frame just finished
+    QUEUE_BLOCK             //stall the recv thread until the consumer takes a frame
+};
+
+/** Receive counters：
+*   poll_calls,recv_calls ( syscalls spent waiting for and reading datagrams )
+*   recv_packets ( packets handed to analysePacket )
+*   packets per syscall = recv_packets / (poll_calls + recv_calls)
+*   queued_frames ( frames put into the queue )
+*   dropped_frames ( finished frames discarded by QUEUE_DROP_NEWEST )
+*   overwritten_frames ( queued frames discarded by QUEUE_DROP_OLDEST )
+*   overflow_blocks ( blocks lost because the frame buffer was full, check rpm and laser_num if not 0 )
+*/
+typedef struct tagDriverStats
+{
+    unsigned long long poll_calls;
+    unsigned long long recv_calls;
+    unsigned long long recv_packets;
+    unsigned long long queued_frames;
+    unsigned long long dropped_frames;
+    unsigned long long overwritten_frames;
+    unsigned long long overflow_blocks;
+}DriverStats,*DriverStats_ptr;
 
 class VeloDriver
 {
 public:
     //Constructor and destructor
-    VeloDriver(const char * device_ip,const unsigned int data_port);
+    //1.live device, or the capture in driver_config->pcap_file
+    VeloDriver(const char * device_ip,const unsigned int data_port,const DriverConfig * driver_config = nullptr);
+    //2.any packet source, kept by the caller until the driver is destroyed
+    VeloDriver(PacketSource * packet_source,const DriverConfig * driver_config = nullptr);
     ~VeloDriver();
 
     //API, member functions
-    //1.the signal of whether there is a new data
+    //1.the signal of whether there is a new data, wait until the oldest queued frame is in raw_data.
+    //0 once a replayed capture has ended and every frame was taken.
+    //each variant gives the frame held in raw_data back to the pool first
     int newData();
+    //2.take a queued frame without waiting, 0 and raw_data = nullptr if there is none
+    int tryNewData();
+    //3.wait at most timeout_ms for a frame, 0 and raw_data = nullptr on timeout
+    int timedNewData(unsigned int timeout_ms);
+    //4.give raw_data back to the pool before the next newData()
+    void releaseData();
+    //5.snapshot of the receive counters
+    void getStats(DriverStats & stats);
+    //6.fill the configure with default values
+    static void defaultConfig(DriverConfig & driver_config);
+    //7.move the frame cut, 100 * degree, takes effect from the next block
+    void setCutAngle(unsigned int cut_angle);
+    //8.model and return mode of the packets, set before the first frame is queued,
+    //MODEL_UNKNOWN until then
+    SensorInfo getSensor(){return sensor;}
 
     //API, member variables
-    //1.memory for one raw lidar data frame
+    //1.raw lidar data frame owned by the caller until the next newData()/releaseData(),
+    //only frame_block[0,block_num) is valid, the buffer holds max_block_num blocks.
+    //raw_data->cloud holds its points when DriverConfig::calib is set
     FrameData_ptr raw_data;
 
 private:
     //member variables
-    //1.socket id
-    int sock_fd;
-    in_addr dev_ip;
-    //2.recv thread id and handle
+    //1.where the packets come from, deleted with the driver if own_source
+    PacketSource * source;
+    bool own_source;
+    //2.recv thread id and handle, the thread leaves at the end of the source or when recv_stop is set
     std::thread recv_thread_handle;
-    //3.thread lock ,flag and signal
+    std::atomic<bool> recv_stop;
+    std::atomic<bool> recv_end;
+    //3.thread lock ,flag and signal, only used to sleep on an empty or full queue
     pthread_mutex_t pack_lock;
     pthread_cond_t  pack_new_signal;
+    pthread_cond_t  pack_free_signal;
+    std::atomic<bool> consumer_waiting;
+    std::atomic<bool> producer_waiting;
     //4.current scanning angle and last scanning angle for
-    //cutting data into independent frames
+    //cutting data into independent frames and sectors
     unsigned short curr_rot_ang;
     unsigned short last_rot_ang;
-    //5.the id number of frames
+    bool rot_ang_valid;
+    std::atomic<unsigned int> cut_rot_ang;
+    unsigned int sector_rot_ang;
+    unsigned int sector_packet_num;
+    //5.the id number of frames and of the sector in the current frame
     unsigned int frame_id;
-    //6.memory for save the temp data from lidar device
+    unsigned short sector_id;
+    //6.frame buffer being filled with the temp data from lidar device
     FrameData_ptr recv_data;
-    //7.memory for pass data between two threads
-    FrameData_ptr pass_data;
+    bool recv_overflow;
+    //blocks of recv_data already in its cloud
+    unsigned int conv_block_num;
+    //7.finished frames waiting for the consumer, oldest first
+    FrameQueue * pass_queue;
+    //8.configures of the driver
+    DriverConfig config;
+    //9.packets handed out by the source in one batch
+    const char ** batch_packets;
+    int * batch_lens;
+    //10.frame buffer pool, buffers move between recv_data, pass_queue
+    //and raw_data by pointer, free_queue gives idle ones back to the recv thread.
+    //the buffers are created for the sensor found in the first packet
+    FrameData_ptr * frame_pool;
+    unsigned int pool_num;
+    FrameQueue * free_queue;
+    //11.receive counters
+    std::atomic<unsigned long long> recv_packets;
+    std::atomic<unsigned long long> queued_frames;
+    std::atomic<unsigned long long> dropped_frames;
+    std::atomic<unsigned long long> overwritten_frames;
+    std::atomic<unsigned long long> overflow_blocks;
+    //12.sensor of the packets and the block analysis of its model and return mode, picked once
+    SensorInfo sensor;
+    typedef void (VeloDriver::*AnalyseFunc)(const unsigned char * p_data);
+    AnalyseFunc analyse_blocks;
 
     //member functions
     //1.Init all variables
-    void variableInit();
+    void variableInit(const DriverConfig * driver_config);
     //2.Free all variables
     void variableFree();
-    //3.get packet from the device
+    //3.queue the finished recv_data following the drop policy and start a new one
+    void publishFrame(bool last_sector);
+    //whether the scan moving from last to curr passes target, all in 100 * degree
+    static bool passAngle(unsigned int last, unsigned int curr, unsigned int target);
+    //take the oldest queued frame into raw_data
+    int takeFrame();
+    //4.get a batch of packets from the source, 1 at the end of it
     int getPacket();
-    //4.analyse every packet
-    void analysePacket(char* buf, int len);
-    //5.recv thread function
+    //5.analyse every packet, then convert its blocks
+    void analysePacket(const char* buf, int len);
+    template <int Model, int Return>
+    void analyseBlocks(const unsigned char * p_data);
+    void convertBlocks();
+    //find the sensor in the first packet, pick its analysis and create the frame buffers
+    //@return 0: the packet is of no known model
+    int setupSensor(const unsigned char * p_data);
+    //6.recv thread function
     static void recvThread(void *arg);
-    //6.start communication with device
-    void startComm(const char * device_ip,const unsigned int data_port);
 };
 
 
@@ -1,6 +1,84 @@
+/**
+* Conversions and dumps between the FrameData and CompactFrame layouts
+* last modified: 2018.6.5
+*
+* Zhenbo Song(songzb@njust.edu.cn)
+*
+* illustration:
+* FrameData keeps every return as a packed Laser struct, CompactFrame keeps
+* distances, intensities and per block values in separate arrays.
+* A compact .bin dump holds the header and block_num entries of every array.
+* Both layouts are allocated at runtime for the blocks one frame of the
+* sensor can hold at its RPM, so a 32E or a fast spin does not pay for a
+* 64E at low speed.
+*/
 #ifndef __VELO_FRAME_H__
 #define __VELO_FRAME_H__
 
+#include <stdio.h>
+#include "common.h"
+#include "velo_decoder.h"
 
+//the packet timestamp counts us past the hour
+#define HOUR_US         3600000000U
+
+//1.frame containers
+//blocks in one revolution of a laser_num (16, 32 or 64) lidar at rpm, with 20% margin
+unsigned int frameBlockNum(int laser_num, unsigned int rpm);
+//  the same for a model and return mode, dual return doubles the blocks
+unsigned int frameBlockNum(const SensorInfo & sensor, unsigned int rpm);
+//points of one laser in one revolution, with the same margin
+unsigned int frameLinePointNum(int laser_num, unsigned int rpm);
+unsigned int frameLinePointNum(const SensorInfo & sensor, unsigned int rpm);
+//allocate and clear a frame of max_block_num blocks, free with freeFrameData()
+FrameData_ptr createFrameData(unsigned int max_block_num);
+void freeFrameData(FrameData_ptr frame);
+CompactFrame_ptr createCompactFrame(unsigned int max_block_num);
+void freeCompactFrame(CompactFrame_ptr compact);
+//allocate and clear the LASER_NUM lines of max_line_point points (frameLinePointNum()),
+//free with freeOriginData() / freePointCloud()
+OriginData_ptr createOriginData(unsigned int max_line_point);
+void freeOriginData(OriginData_ptr origin);
+PointCloud_ptr createPointCloud(unsigned int max_line_point);
+void freePointCloud(PointCloud_ptr cloud);
+
+//2.layout conversions, only frame_block[0,block_num) is touched,
+//  blocks beyond the capacity of the destination are dropped
+void frameToCompact(const FrameData * frame, CompactFrame * compact);
+void compactToFrame(const CompactFrame * compact, FrameData * frame);
+
+//3.decode the 12 blocks of one packet at the end of the compact frame
+//  @return 1: ok; 0: the frame is full
+int appendPacket(VeloDecoder & decoder, const unsigned char * packet, CompactFrame * compact);
+
+//  firing time of each of the 12 blocks of one packet, us past the hour as the packet timestamp,
+//  which is the time of the first firing. the 64E fires an upper block and the lower block after it
+//  together every 48 us, the 32E one block every 46.08 us
+void blockTimeStampe(const unsigned short * upper_or_lower, unsigned int packet_time_stampe, unsigned int * time_stampe);
+//  the same from SensorTraits of a known model and return mode, the blocks of a firing time
+//  (upper and lower, each twice with dual return) share it, a block covers firing_per_block firings
+template <int Model, int Return>
+inline void blockTimeStampeT(unsigned int packet_time_stampe, unsigned int * time_stampe)
+{
+    typedef SensorTraits<Model> Traits;
+    const int time_block_num = Traits::block_per_firing * (Return == RETURN_DUAL ? 2 : 1);
+    const double block_period = Traits::firing_per_block * Traits::firing_period;
+    for(int i = 0; i < 12; i++)
+    {
+        unsigned int time = packet_time_stampe + (unsigned int)(i / time_block_num * block_period + 0.5);
+        time_stampe[i] = time >= HOUR_US ? time - HOUR_US : time;
+    }
+}
+
+//  appendPacket specialized on the model and the return mode of detectSensor(), picked once for a
+//  stream: the firing times of the blocks come from SensorTraits instead of the block headers.
+//  appendPacket itself for MODEL_UNKNOWN
+typedef int (*AppendPacketFunc)(VeloDecoder & decoder, const unsigned char * packet, CompactFrame * compact);
+AppendPacketFunc packetAppender(const SensorInfo & sensor);
+
+//4.compact .bin dumps
+//  @return 1: ok; 0: file error, not a compact dump or larger than max_block_num
+int saveCompactFrame(FILE * fp, const CompactFrame * compact);
+int loadCompactFrame(FILE * fp, CompactFrame * compact);
 
 #endif
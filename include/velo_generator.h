@@ -0,0 +1,87 @@
+/**
+* Synthetic Velodyne 64E/32E data packets for load testing
+* last modified: 2018.6.5
+*
+* Zhenbo Song(songzb@njust.edu.cn)
+*
+* illustration:
+* stp1（describe the sensor and the scene): VeloGenerator(GeneratorConfig * generator_config);
+* stp2（build packets in firing order）: while(...) buildPacket(packet);
+* Packets follow the layout VeloDriver::analysePacket parses: 12 blocks of
+* block id, rotation angle and 32 lasers x (distance, intensity), then the
+* timestamp and the two status bytes.
+*/
+#ifndef __VELO_GENERATOR_H__
+#define __VELO_GENERATOR_H__
+
+#include "velo_decoder.h"
+
+/** Configure inparameter：
+*   laser_num ( 64 for upper/lower block pairs (64E), 32 for upper blocks only (32E),
+*               16 for two firings per block (VLP-16) )
+*   return_mode ( RETURN_STRONGEST, RETURN_LAST or RETURN_DUAL, the scene has one return
+*                 so both returns of a dual packet are the same )
+*   rpm ( rotation speed, round per minute )
+*   scene ( SCENE_RING, SCENE_GROUND or SCENE_ROOM )
+*   height ( mounting height above the ground, m )
+*   room_x,room_y ( half size of the room around the sensor, m )
+*   start_angle ( 100 * degree of the first firing, to dephase several sensors )
+*/
+typedef struct tagGeneratorConfig
+{
+    int laser_num;
+    int return_mode;
+    unsigned int rpm;
+    int scene;
+    double height;
+    double room_x;
+    double room_y;
+    unsigned int start_angle;
+}GeneratorConfig,*GeneratorConfig_ptr;
+
+enum
+{
+    SCENE_RING = 0,     //every laser at a fixed range, 10 m + 1 m per laser
+    SCENE_GROUND,       //flat ground, lasers above the horizon return nothing
+    SCENE_ROOM          //flat ground inside four walls
+};
+
+class VeloGenerator
+{
+public:
+    //Constructor and destructor
+    VeloGenerator(const GeneratorConfig * generator_config);
+    ~VeloGenerator(){}
+
+    //API,member functions
+    //1.write the next PACKET_SIZE bytes data packet
+    void buildPacket(unsigned char * packet);
+    //2.time between two packets, us
+    double packetPeriod();
+    //3.fill the configure with default values
+    static void defaultConfig(GeneratorConfig & generator_config);
+
+private:
+    //member variables
+    //1.configures of the generator, the model of laser_num and its layout
+    GeneratorConfig config;
+    int model;
+    SensorLayout layout;
+    //2.azimuth step between two firings and current azimuth, 100 * degree
+    double rot_step;
+    double rot_ang;
+    //3.firing period, us, and the packet timestamp
+    double firing_period;
+    double time_stamp;
+    //4.vertical angle of every laser, upper block first
+    double sin_vert[64];
+    double cos_vert[64];
+
+    //member functions
+    //1.horizontal distance to the walls at one azimuth, m
+    double wallRange(double azimuth);
+    //2.range of one laser, 2 mm, 0 for no return
+    unsigned short sceneDistance(int laser, double wall_range);
+};
+
+#endif
@@ -0,0 +1,49 @@
+/**
+* Azimuth tables of VeloCalib generated at build time
+* last modified: 2018.6.5
+*
+* Zhenbo Song(songzb@njust.edu.cn)
+*
+* illustration:
+* trig_table_gen writes velo_trig_table.cpp into the build directory with
+* the entries below as constant initializers, so the tables sit in .rodata,
+* shared through the page cache and free at startup. velo_trig_table_check
+* compares them with the libm values of veloAzimuthRadian().
+*/
+#ifndef __VELO_TRIG_TABLE_H__
+#define __VELO_TRIG_TABLE_H__
+
+#include <math.h>
+
+//entries of the azimuth tables, one per 0.01 degree
+#define AZIMUTH_NUM 36000
+
+//cos and sin of the azimuth in Real, then in Q15 for the fixed point conversion
+template <typename Real>
+struct VeloTrigTable
+{
+    Real cos_rot_table[AZIMUTH_NUM];
+    Real sin_rot_table[AZIMUTH_NUM];
+    short cos_rot_table_q15[AZIMUTH_NUM];
+    short sin_rot_table_q15[AZIMUTH_NUM];
+};
+
+extern const VeloTrigTable<double> velo_trig_table_double;
+extern const VeloTrigTable<float> velo_trig_table_float;
+
+inline const VeloTrigTable<double> & veloTrigTable(const double *){return velo_trig_table_double;}
+inline const VeloTrigTable<float> & veloTrigTable(const float *){return velo_trig_table_float;}
+
+//azimuth of entry i in radian
+inline double veloAzimuthRadian(int i)
+{
+    return (double)(i*M_PI/180.0/100.0);
+}
+
+//Q15 of a cos or sin, 1.0 saturates to 32767
+inline short veloQ15(double value)
+{
+    return (short)fmin(32767.0,lround(value * 32768));
+}
+
+#endif
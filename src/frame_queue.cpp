@@ -0,0 +1,57 @@
+#include "frame_queue.h"
+
+FrameQueue::FrameQueue(unsigned int capacity)
+{
+    cap = capacity < 1 ? 1 : capacity;
+    slots = new std::atomic<FrameData_ptr>[cap];
+    for(unsigned int i = 0; i < cap; i++)
+    {
+        slots[i].store(nullptr);
+    }
+    head = 0;
+    tail = 0;
+}
+
+FrameQueue::~FrameQueue()
+{
+    delete [] slots;
+}
+
+bool FrameQueue::push(FrameData_ptr frame)
+{
+    unsigned long long t = tail.load(std::memory_order_relaxed);
+    if(t - head.load() >= cap)
+    {
+        return false;
+    }
+    slots[t % cap].store(frame,std::memory_order_relaxed);
+    //index updates are seq_cst so that a thread going to sleep on an empty or
+    //full queue either sees the change or is seen by the other side's wakeup check
+    tail.store(t + 1);
+    return true;
+}
+
+FrameData_ptr FrameQueue::pop()
+{
+    unsigned long long h = head.load();
+    while(true)
+    {
+        if(h == tail.load())
+        {
+            return nullptr;
+        }
+        FrameData_ptr frame = slots[h % cap].load(std::memory_order_relaxed);
+        //the slot is only trusted once the head is claimed, a failed CAS reloads h
+        if(head.compare_exchange_weak(h,h + 1))
+        {
+            return frame;
+        }
+    }
+}
+
+unsigned int FrameQueue::size()
+{
+    unsigned long long h = head.load();
+    unsigned long long t = tail.load();
+    return t > h ? (unsigned int)(t - h) : 0;
+}
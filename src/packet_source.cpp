@@ -0,0 +1,358 @@
+#include <string.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <poll.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <time.h>
+
+#include "packet_source.h"
+
+/** @brief constructor
+ *  @param device IP in char array
+ *  @param data port
+ *  @param max datagrams drained by one recvmmsg() per wakeup, 1 uses poll()+recvfrom()
+ */
+UdpSource::UdpSource(const char *device_ip, const unsigned int data_port, const unsigned int batch_num)
+{
+    sock_fd = -1;
+    dev_ip.s_addr = 0;
+    //packet ring: batch_num datagrams received by a single recvmmsg()
+    ring_num = batch_num < 1 ? 1 : batch_num;
+    packet_ring = new char[ring_num * PACKET_BUF_SIZE];
+    ring_msgs = new mmsghdr[ring_num];
+    ring_iovs = new iovec[ring_num];
+    ring_addrs = new sockaddr_in[ring_num];
+    memset(ring_msgs,0,sizeof(mmsghdr) * ring_num);
+    for(unsigned int i = 0; i < ring_num; i++)
+    {
+        ring_iovs[i].iov_base = packet_ring + i * PACKET_BUF_SIZE;
+        ring_iovs[i].iov_len = PACKET_BUF_SIZE;
+        ring_msgs[i].msg_hdr.msg_iov = &ring_iovs[i];
+        ring_msgs[i].msg_hdr.msg_iovlen = 1;
+        ring_msgs[i].msg_hdr.msg_name = &ring_addrs[i];
+    }
+    startComm(device_ip,data_port);
+}
+
+UdpSource::~UdpSource()
+{
+    if(sock_fd >= 0)
+    {
+        (void)close(sock_fd);
+    }
+    delete [] packet_ring;
+    delete [] ring_msgs;
+    delete [] ring_iovs;
+    delete [] ring_addrs;
+}
+
+void UdpSource::startComm(const char * device_ip,const unsigned int data_port)
+{
+    //open the socket and bind with the device ip
+    if (device_ip!=nullptr)
+    {
+        inet_aton(device_ip,&dev_ip);
+    }
+    sock_fd = socket(PF_INET, SOCK_DGRAM, 0);
+    if (sock_fd == -1)
+    {
+        perror("socket");
+        return;
+    }
+    sockaddr_in my_addr;                     // my address information
+    memset(&my_addr, 0, sizeof(my_addr));    // initialize to zeros
+    my_addr.sin_family = AF_INET;            // host byte order
+    my_addr.sin_port = htons(data_port);     // port in network byte order
+    my_addr.sin_addr.s_addr = INADDR_ANY;    // automatically fill in my IP
+    if (bind(sock_fd, (sockaddr *)&my_addr, sizeof(sockaddr)) == -1)
+    {
+        perror("bind");
+        return;
+    }
+    if (fcntl(sock_fd,F_SETFL, O_NONBLOCK|FASYNC) < 0)
+    {
+        perror("non-block");
+        return;
+    }
+}
+
+/** @brief wait for the socket to be readable
+ *  @return 0: readable; 1: poll error; 2: timeout
+ */
+int UdpSource::pollSocket()
+{
+    struct pollfd fds[1];
+    fds[0].fd = sock_fd;
+    fds[0].events = POLLIN;
+    static const int POLL_TIMEOUT = 1*1000; // 120 seconds (in msec)
+
+    // the Linux kernel recvfrom() implementation
+    // uses a non-interruptible sleep() when waiting for data,
+    // which would cause this method to hang if the device is not
+    // providing data.  We poll() the device first to make sure
+    // the recvfrom() will not block.
+    //
+    // Note, however, that there is a known Linux kernel bug:
+    //
+    //   Under Linux, select() may report a socket file descriptor
+    //   as "ready for reading", while nevertheless a subsequent
+    //   read blocks.  This could for example happen when data has
+    //   arrived but upon examination has wrong checksum and is
+    //   discarded.  There may be other circumstances in which a
+    //   file descriptor is spuriously reported as ready.  Thus it
+    //   may be safer to use O_NONBLOCK on sockets that should not
+    //   block.
+    // poll() until input available
+    do
+    {
+        int retval = poll(fds, 1, POLL_TIMEOUT);
+        poll_calls ++;
+        if (retval < 0)             // poll() error?
+        {
+            if (errno != EINTR)
+                perror("poll() error");
+            return 1;
+        }
+        if (retval == 0)            // poll() timeout?
+        {
+            printf("WRN:Velodyne poll() timeout\n");
+            return 2;
+        }
+        if ((fds[0].revents & POLLERR)
+                || (fds[0].revents & POLLHUP)
+                || (fds[0].revents & POLLNVAL)) // device error?
+        {
+            printf("ERRO:poll() reports Velodyne error\n");
+            return 1;
+        }
+    } while ((fds[0].revents & POLLIN) == 0);
+    return 0;
+}
+
+/** @brief receive the datagrams queued on the socket, one recvfrom() or one
+ *  recvmmsg() after each poll() wakeup
+ */
+int UdpSource::nextPackets(const char **packets, int *lens, int max_num)
+{
+    //stp1. timeout function
+    int poll_key = pollSocket();
+    if (poll_key == 1)
+    {
+        return -1;
+    }
+    if (poll_key == 2)
+    {
+        return 0;
+    }
+
+    //stp2.Receive packets that should now be available from the
+    //socket using a non-blocking read.
+    unsigned int want_num = (unsigned int)max_num < ring_num ? max_num : ring_num;
+    int npackets;
+    if(want_num == 1)
+    {
+        socklen_t sender_address_len = sizeof(sockaddr_in);
+        ssize_t nbytes = recvfrom(sock_fd, packet_ring, PACKET_BUF_SIZE,  0,
+                                  (sockaddr*) &ring_addrs[0],
+                                  &sender_address_len);
+        ring_msgs[0].msg_len = nbytes < 0 ? 0 : nbytes;
+        npackets = nbytes < 0 ? -1 : 1;
+    }
+    else
+    {
+        for(unsigned int i = 0; i < want_num; i++)
+        {
+            ring_msgs[i].msg_hdr.msg_namelen = sizeof(sockaddr_in);
+        }
+        npackets = recvmmsg(sock_fd, ring_msgs, want_num, MSG_DONTWAIT, nullptr);
+    }
+    recv_calls ++;
+    if (npackets < 0)
+    {
+        if (errno != EWOULDBLOCK && errno != EINTR)
+        {
+            perror("recvfail");
+            return -1;
+        }
+        return 0;
+    }
+
+    //stp3. hand out the ring slots in receiving order
+    bool wrong_ip = false;
+    for(int i = 0; i < npackets; i++)
+    {
+        packets[i] = packet_ring + i * PACKET_BUF_SIZE;
+        lens[i] = (int)ring_msgs[i].msg_len;
+        if(ring_addrs[i].sin_addr.s_addr != dev_ip.s_addr)
+        {
+            wrong_ip = true;
+        }
+    }
+    if(wrong_ip)
+    {
+        printf("WRN:recv ip is not the same with device ip\n");
+    }
+    return npackets;
+}
+
+/** @brief constructor, map the capture
+ *  @param pcap file path
+ *  @param only replay packets from this IP, nullptr for any
+ *  @param udp port of the data packets in the capture
+ *  @param REPLAY_REALTIME or REPLAY_MAX_SPEED
+ */
+PcapSource::PcapSource(const char *pcap_file, const char *device_ip, const unsigned int data_port, int replay_mode)
+    : reader(pcap_file,data_port)
+{
+    dev_ip.s_addr = 0;
+    if (device_ip!=nullptr)
+    {
+        inet_aton(device_ip,&dev_ip);
+    }
+    if(!reader.isOpen())
+    {
+        printf("ERRO:can not replay %s\n",pcap_file);
+    }
+    mode = replay_mode;
+    replay_stamp = -1;
+    replay_clock = 0;
+}
+
+/** @brief the next packets of the capture, paced by the pcap time stamps
+ *  in REPLAY_REALTIME mode
+ */
+int PcapSource::nextPackets(const char **packets, int *lens, int max_num)
+{
+    const unsigned char * payload;
+    int len;
+    double time_stamp;
+    unsigned int src_ip;
+    int npackets = 0;
+    while(npackets < max_num)
+    {
+        if(!reader.nextPacket(&payload,&len,&time_stamp,&src_ip))
+        {
+            return npackets > 0 ? npackets : -1;
+        }
+        if(dev_ip.s_addr != 0 && src_ip != dev_ip.s_addr)
+        {
+            continue;
+        }
+        if(mode == REPLAY_REALTIME)
+        {
+            timespec now;
+            clock_gettime(CLOCK_MONOTONIC,&now);
+            double now_clock = now.tv_sec + now.tv_nsec * 1e-9;
+            if(replay_stamp < 0)
+            {
+                replay_stamp = time_stamp;
+                replay_clock = now_clock;
+            }
+            double wait_time = (time_stamp - replay_stamp) - (now_clock - replay_clock);
+            if(wait_time > 0)
+            {
+                //hand out what is due before sleeping
+                if(npackets > 0)
+                {
+                    reader.stepBack();
+                    return npackets;
+                }
+                timespec wait_span;
+                wait_span.tv_sec = (time_t)wait_time;
+                wait_span.tv_nsec = (long)((wait_time - wait_span.tv_sec) * 1e9);
+                nanosleep(&wait_span,nullptr);
+            }
+        }
+        packets[npackets] = (const char *)payload;
+        lens[npackets] = len;
+        npackets ++;
+    }
+    return npackets;
+}
+
+/** @brief constructor
+ *  @param packet_num packets of PACKET_SIZE bytes back to back
+ *  @param number of packets
+ *  @param times to replay the buffer
+ */
+MemorySource::MemorySource(const char *packets, const unsigned int packet_num, const unsigned int loop_num)
+{
+    data = packets;
+    data_num = packet_num;
+    loop_left = packet_num > 0 ? loop_num : 0;
+    index = 0;
+}
+
+int MemorySource::nextPackets(const char **packets, int *lens, int max_num)
+{
+    int npackets = 0;
+    while(npackets < max_num && loop_left > 0)
+    {
+        packets[npackets] = data + (size_t)index * PACKET_SIZE;
+        lens[npackets] = PACKET_SIZE;
+        npackets ++;
+        if(++index == data_num)
+        {
+            index = 0;
+            loop_left --;
+        }
+    }
+    return npackets > 0 ? npackets : -1;
+}
+
+/** @brief constructor
+ *  @param 64 for upper/lower block pairs, 32 for upper blocks only
+ *  @param rotation speed, round per minute
+ *  @param number of packets, 0 for an endless source
+ *  @param scene model of the generator
+ */
+GeneratorSource::GeneratorSource(const unsigned int laser_num, const unsigned int rpm, const unsigned long long packet_num, const int scene)
+{
+    GeneratorConfig generator_config;
+    VeloGenerator::defaultConfig(generator_config);
+    generator_config.laser_num = laser_num;
+    generator_config.rpm = rpm;
+    generator_config.scene = scene;
+    variableInit(&generator_config,packet_num);
+}
+
+GeneratorSource::GeneratorSource(const GeneratorConfig *generator_config, const unsigned long long packet_num)
+{
+    variableInit(generator_config,packet_num);
+}
+
+void GeneratorSource::variableInit(const GeneratorConfig *generator_config, const unsigned long long packet_num)
+{
+    generator = new VeloGenerator(generator_config);
+    packet_left = packet_num;
+    endless = (packet_num == 0);
+    ring_num = 64;
+    packet_ring = new char[ring_num * PACKET_SIZE];
+}
+
+GeneratorSource::~GeneratorSource()
+{
+    delete generator;
+    delete [] packet_ring;
+}
+
+int GeneratorSource::nextPackets(const char **packets, int *lens, int max_num)
+{
+    int npackets = 0;
+    while(npackets < max_num && npackets < (int)ring_num && (endless || packet_left > 0))
+    {
+        char * packet = packet_ring + (size_t)npackets * PACKET_SIZE;
+        generator->buildPacket((unsigned char *)packet);
+        packets[npackets] = packet;
+        lens[npackets] = PACKET_SIZE;
+        npackets ++;
+        if(!endless)
+        {
+            packet_left --;
+        }
+    }
+    return npackets > 0 ? npackets : -1;
+}
@@ -0,0 +1,195 @@
+#include "pcap_reader.h"
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+//pcap magic numbers and link layer types
+#define PCAP_MAGIC_USEC     0xa1b2c3d4
+#define PCAP_MAGIC_NSEC     0xa1b23c4d
+#define PCAP_GLOBAL_SIZE    24
+#define PCAP_RECORD_SIZE    16
+#define LINKTYPE_NULL       0
+#define LINKTYPE_ETHERNET   1
+#define LINKTYPE_RAW        101
+#define LINKTYPE_LINUX_SLL  113
+
+/** @brief constructor, map the capture into memory
+ *  @param pcap file path
+ *  @param udp destination port of the data packets
+ */
+PcapReader::PcapReader(const char *file_dir, const unsigned int data_port)
+{
+    file_data = nullptr;
+    file_size = 0;
+    file_offset = 0;
+    last_offset = 0;
+    port = data_port;
+    int fd = open(file_dir,O_RDONLY);
+    if(fd < 0)
+    {
+        perror("pcap open");
+        return;
+    }
+    struct stat file_stat;
+    if(fstat(fd,&file_stat) < 0 || file_stat.st_size < PCAP_GLOBAL_SIZE)
+    {
+        printf("ERRO:pcap file is too short\n");
+        close(fd);
+        return;
+    }
+    void * addr = mmap(nullptr,file_stat.st_size,PROT_READ,MAP_PRIVATE,fd,0);
+    close(fd);
+    if(addr == MAP_FAILED)
+    {
+        perror("pcap mmap");
+        return;
+    }
+    //the file is walked once front to back
+    madvise(addr,file_stat.st_size,MADV_SEQUENTIAL);
+    file_data = (const unsigned char *)addr;
+    file_size = file_stat.st_size;
+    if(!readHeader())
+    {
+        munmap((void *)file_data,file_size);
+        file_data = nullptr;
+    }
+}
+
+PcapReader::~PcapReader()
+{
+    if(file_data != nullptr)
+    {
+        munmap((void *)file_data,file_size);
+    }
+}
+
+int PcapReader::readHeader()
+{
+    unsigned int magic = file_data[0] | (file_data[1]<<8) | (file_data[2]<<16) | ((unsigned int)file_data[3]<<24);
+    unsigned int magic_swap = __builtin_bswap32(magic);
+    if(magic == PCAP_MAGIC_USEC || magic == PCAP_MAGIC_NSEC)
+    {
+        swap_order = false;
+    }
+    else if(magic_swap == PCAP_MAGIC_USEC || magic_swap == PCAP_MAGIC_NSEC)
+    {
+        swap_order = true;
+        magic = magic_swap;
+    }
+    else
+    {
+        printf("ERRO:not a pcap file (pcapng is not supported)\n");
+        return 0;
+    }
+    nano_stamp = (magic == PCAP_MAGIC_NSEC);
+    link_type = readU32(file_data + 20) & 0xffff;
+    if(link_type != LINKTYPE_ETHERNET && link_type != LINKTYPE_LINUX_SLL &&
+            link_type != LINKTYPE_RAW && link_type != LINKTYPE_NULL)
+    {
+        printf("ERRO:pcap link type %u is not supported\n",link_type);
+        return 0;
+    }
+    file_offset = PCAP_GLOBAL_SIZE;
+    return 1;
+}
+
+unsigned int PcapReader::readU32(const unsigned char *p)
+{
+    unsigned int value = p[0] | (p[1]<<8) | (p[2]<<16) | ((unsigned int)p[3]<<24);
+    return swap_order ? __builtin_bswap32(value) : value;
+}
+
+int PcapReader::ipOffset(const unsigned char *frame, int len)
+{
+    int offset = 0;
+    unsigned int ether_type = 0x0800;
+    if(link_type == LINKTYPE_ETHERNET)
+    {
+        offset = 14;
+        if(len < offset) return -1;
+        ether_type = (frame[12]<<8) | frame[13];
+        //skip 802.1Q / 802.1ad tags
+        while((ether_type == 0x8100 || ether_type == 0x88a8) && len >= offset + 4)
+        {
+            ether_type = (frame[offset+2]<<8) | frame[offset+3];
+            offset += 4;
+        }
+    }
+    else if(link_type == LINKTYPE_LINUX_SLL)
+    {
+        offset = 16;
+        if(len < offset) return -1;
+        ether_type = (frame[14]<<8) | frame[15];
+    }
+    else if(link_type == LINKTYPE_NULL)
+    {
+        offset = 4;
+    }
+    if(ether_type != 0x0800 || len < offset + 20 || (frame[offset] >> 4) != 4)
+    {
+        return -1;
+    }
+    return offset;
+}
+
+int PcapReader::nextPacket(const unsigned char **payload, int *len, double *time_stamp, unsigned int *src_ip)
+{
+    while(file_data != nullptr && file_offset + PCAP_RECORD_SIZE <= file_size)
+    {
+        //stp1.record header
+        const unsigned char * record = file_data + file_offset;
+        unsigned int ts_sec = readU32(record);
+        unsigned int ts_frac = readU32(record + 4);
+        unsigned int incl_len = readU32(record + 8);
+        if(file_offset + PCAP_RECORD_SIZE + incl_len > file_size)
+        {
+            //truncated last record
+            break;
+        }
+        const unsigned char * frame = record + PCAP_RECORD_SIZE;
+        last_offset = file_offset;
+        file_offset += PCAP_RECORD_SIZE + incl_len;
+
+        //stp2.ipv4 header, unfragmented udp only
+        int ip_offset = ipOffset(frame,incl_len);
+        if(ip_offset < 0)
+        {
+            continue;
+        }
+        const unsigned char * ip = frame + ip_offset;
+        int ip_header_len = (ip[0] & 0x0f) * 4;
+        if(ip[9] != 17 || (((ip[6] & 0x3f)<<8) | ip[7]) != 0 ||
+                (int)incl_len < ip_offset + ip_header_len + 8)
+        {
+            continue;
+        }
+
+        //stp3.udp header
+        const unsigned char * udp = ip + ip_header_len;
+        unsigned int dst_port = (udp[2]<<8) | udp[3];
+        int udp_len = ((udp[4]<<8) | udp[5]) - 8;
+        if(dst_port != port || udp_len < 0 || (int)incl_len < ip_offset + ip_header_len + 8 + udp_len)
+        {
+            continue;
+        }
+        *payload = udp + 8;
+        *len = udp_len;
+        *time_stamp = ts_sec + ts_frac * (nano_stamp ? 1e-9 : 1e-6);
+        if(src_ip != nullptr)
+        {
+            //network byte order, same as in_addr.s_addr
+            memcpy(src_ip,ip + 12,4);
+        }
+        return 1;
+    }
+    return 0;
+}
+
+void PcapReader::rewind()
+{
+    file_offset = PCAP_GLOBAL_SIZE;
+    last_offset = PCAP_GLOBAL_SIZE;
+}
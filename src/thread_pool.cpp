@@ -0,0 +1,241 @@
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <new>
+#include <sched.h>
+#include <unistd.h>
+
+#include "thread_pool.h"
+
+
+/** @brief constructor, the pool threads are started here and sleep between the runs
+ *  @param configure of the pool, nullptr for the default one
+ */
+ThreadPool::ThreadPool(const PoolConfig *pool_config)
+{
+    variableInit(pool_config);
+}
+
+ThreadPool::~ThreadPool()
+{
+    pthread_mutex_lock(&pool_lock);
+    stop = true;
+    pthread_cond_broadcast(&start_signal);
+    pthread_mutex_unlock(&pool_lock);
+    for(int i = 1; i < thread_num; i++)
+    {
+        threads[i].join();
+    }
+    variableFree();
+}
+
+void ThreadPool::defaultConfig(PoolConfig &pool_config)
+{
+    memset(&pool_config,0,sizeof(PoolConfig));
+    pool_config.thread_num = 0;
+    pool_config.affinity = 0;
+    pool_config.first_cpu = 0;
+}
+
+void ThreadPool::variableInit(const PoolConfig *pool_config)
+{
+    defaultConfig(config);
+    if(pool_config != nullptr)
+    {
+        memcpy(&config,pool_config,sizeof(PoolConfig));
+    }
+    int cpu_num = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if(cpu_num < 1)
+    {
+        cpu_num = 1;
+    }
+    thread_num = config.thread_num > 0 ? config.thread_num : cpu_num;
+
+    task_func = nullptr;
+    task_arg = nullptr;
+    generation = 0;
+    busy_num = 0;
+    stop = false;
+    steal_num = 0;
+
+    //cache line aligned, new does not align beyond 16 bytes before c++17
+    void * buf = nullptr;
+    if(posix_memalign(&buf,64,thread_num * sizeof(TaskRange)) != 0)
+    {
+        //as new[] does
+        throw std::bad_alloc();
+    }
+    ranges = (TaskRange *)buf;
+    for(int i = 0; i < thread_num; i++)
+    {
+        new (&ranges[i]) TaskRange;
+        ranges[i].range = 0;
+    }
+    pthread_mutex_init(&pool_lock,nullptr);
+    pthread_cond_init(&start_signal,nullptr);
+    pthread_cond_init(&done_signal,nullptr);
+
+    threads = new std::thread[thread_num];
+    for(int i = 1; i < thread_num; i++)
+    {
+        threads[i] = std::thread(workerThread,this,i);
+        if(config.affinity)
+        {
+            cpu_set_t cpu_set;
+            CPU_ZERO(&cpu_set);
+            CPU_SET((config.first_cpu + i) % cpu_num,&cpu_set);
+            if(pthread_setaffinity_np(threads[i].native_handle(),sizeof(cpu_set),&cpu_set) != 0)
+            {
+                printf("WRN:worker %d can not be pinned to cpu %d\n",i,(config.first_cpu + i) % cpu_num);
+            }
+        }
+    }
+}
+
+void ThreadPool::variableFree()
+{
+    delete [] threads;
+    threads = nullptr;
+    for(int i = 0; ranges != nullptr && i < thread_num; i++)
+    {
+        ranges[i].~TaskRange();
+    }
+    free(ranges);
+    ranges = nullptr;
+    pthread_mutex_destroy(&pool_lock);
+    pthread_cond_destroy(&start_signal);
+    pthread_cond_destroy(&done_signal);
+}
+
+/** @brief split the tasks evenly over the workers, wake them and work as worker 0
+ *  @param number of tasks
+ *  @param task function
+ *  @param argument handed to every call
+ */
+void ThreadPool::run(int task_num, PoolTask func, void *arg)
+{
+    if(task_num <= 0)
+    {
+        return;
+    }
+    task_func = func;
+    task_arg = arg;
+    steal_num = 0;
+    for(int i = 0; i < thread_num; i++)
+    {
+        unsigned long long begin = (unsigned long long)task_num * i / thread_num;
+        unsigned long long end = (unsigned long long)task_num * (i + 1) / thread_num;
+        ranges[i].range = (begin << 32) | end;
+    }
+    if(thread_num > 1)
+    {
+        pthread_mutex_lock(&pool_lock);
+        busy_num = thread_num - 1;
+        generation ++;
+        pthread_cond_broadcast(&start_signal);
+        pthread_mutex_unlock(&pool_lock);
+    }
+    work(0);
+    if(thread_num > 1)
+    {
+        pthread_mutex_lock(&pool_lock);
+        while(busy_num > 0)
+        {
+            pthread_cond_wait(&done_signal,&pool_lock);
+        }
+        pthread_mutex_unlock(&pool_lock);
+    }
+}
+
+void ThreadPool::work(int worker)
+{
+    while(true)
+    {
+        int task = popTask(worker);
+        if(task >= 0)
+        {
+            task_func(task_arg,task,worker);
+            continue;
+        }
+        if(!stealTask(worker))
+        {
+            return;
+        }
+    }
+}
+
+int ThreadPool::popTask(int worker)
+{
+    unsigned long long range = ranges[worker].range.load();
+    while(true)
+    {
+        unsigned long long begin = range >> 32;
+        unsigned long long end = range & 0xFFFFFFFFULL;
+        if(begin >= end)
+        {
+            return -1;
+        }
+        if(ranges[worker].range.compare_exchange_weak(range,((begin + 1) << 32) | end))
+        {
+            return (int)begin;
+        }
+    }
+}
+
+bool ThreadPool::stealTask(int worker)
+{
+    for(int i = 1; i < thread_num; i++)
+    {
+        int victim = (worker + i) % thread_num;
+        unsigned long long range = ranges[victim].range.load();
+        while(true)
+        {
+            unsigned long long begin = range >> 32;
+            unsigned long long end = range & 0xFFFFFFFFULL;
+            if(begin >= end)
+            {
+                break;
+            }
+            //the victim keeps [begin,middle), the upper half moves to the thief,
+            //whose own share is empty so nobody else changes it meanwhile
+            unsigned long long middle = begin + (end - begin) / 2;
+            if(ranges[victim].range.compare_exchange_weak(range,(begin << 32) | middle))
+            {
+                ranges[worker].range = (middle << 32) | end;
+                steal_num += end - middle;
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+void ThreadPool::workerThread(ThreadPool *pool, int worker)
+{
+    unsigned int seen = 0;
+    while(true)
+    {
+        pthread_mutex_lock(&pool->pool_lock);
+        while(!pool->stop && pool->generation == seen)
+        {
+            pthread_cond_wait(&pool->start_signal,&pool->pool_lock);
+        }
+        if(pool->stop)
+        {
+            pthread_mutex_unlock(&pool->pool_lock);
+            return;
+        }
+        seen = pool->generation;
+        pthread_mutex_unlock(&pool->pool_lock);
+
+        pool->work(worker);
+
+        pthread_mutex_lock(&pool->pool_lock);
+        pool->busy_num --;
+        if(pool->busy_num == 0)
+        {
+            pthread_cond_signal(&pool->done_signal);
+        }
+        pthread_mutex_unlock(&pool->pool_lock);
+    }
+}
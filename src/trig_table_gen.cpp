@@ -0,0 +1,69 @@
+#include "velo_trig_table.h"
+#include <stdio.h>
+#include <math.h>
+
+//one table of AZIMUTH_NUM entries, 8 per line
+static void writeTable(FILE * fp, const char * format, int q15, int use_sin, int precision)
+{
+    fprintf(fp,"    {\n");
+    for(int i = 0; i < AZIMUTH_NUM; i++)
+    {
+        double angle = veloAzimuthRadian(i);
+        double value = use_sin ? sin(angle) : cos(angle);
+        if(i % 8 == 0)
+        {
+            fprintf(fp,"        ");
+        }
+        if(q15)
+        {
+            fprintf(fp,"%d,",veloQ15(value));
+        }
+        else if(precision == 0)
+        {
+            fprintf(fp,format,value);
+        }
+        else
+        {
+            fprintf(fp,format,(double)(float)value);
+        }
+        fprintf(fp,i % 8 == 7 || i == AZIMUTH_NUM - 1 ? "\n" : " ");
+    }
+    fprintf(fp,"    },\n");
+}
+
+//writes the azimuth tables of velo_trig_table.h as a source file
+//usage: trig_table_gen output_file
+int main(int argc, char ** argv)
+{
+    if(argc < 2)
+    {
+        printf("ERRO:usage: trig_table_gen output_file\n");
+        return 1;
+    }
+    FILE * fp = fopen(argv[1],"w");
+    if(fp == nullptr)
+    {
+        printf("ERRO:can not open %s\n",argv[1]);
+        return 1;
+    }
+    fprintf(fp,"//generated by trig_table_gen, do not edit\n");
+    fprintf(fp,"#include \"velo_trig_table.h\"\n\n");
+    //17 and 9 significant digits read back to the same double and float
+    const char * names[2] = {"double","float"};
+    const char * formats[2] = {"%.16e,","%.8ef,"};
+    for(int precision = 0; precision < 2; precision++)
+    {
+        fprintf(fp,"alignas(64) const VeloTrigTable<%s> velo_trig_table_%s =\n{\n",names[precision],names[precision]);
+        writeTable(fp,formats[precision],0,0,precision);
+        writeTable(fp,formats[precision],0,1,precision);
+        writeTable(fp,formats[precision],1,0,precision);
+        writeTable(fp,formats[precision],1,1,precision);
+        fprintf(fp,"};\n\n");
+    }
+    if(fclose(fp) != 0)
+    {
+        printf("ERRO:can not write %s\n",argv[1]);
+        return 1;
+    }
+    return 0;
+}
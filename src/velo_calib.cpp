@@ -1,34 +1,537 @@
 #include "velo_calib.h"
+#include "velo_trig_table.h"
 #include "tinyxml2.h"
 #include <math.h>
+#include <cmath>
+#include <string.h>
+#include <stdlib.h>
+#include <immintrin.h>
+#include <stdio.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
-VeloCalib::VeloCalib(char *calib_file_dir)
+//one laser block: 0xEEFF upper lasers 0-31, 0xDDFF lower lasers 32-63
+#define LOWER_BLOCK 0xDDFF
+
+//binary calibration cache: header, in_param, the sorted scan_table and the extrinsic, offsets from the file
+//start and 64 byte aligned. bump the version when any of these layouts changes
+#define CALIB_CACHE_VERSION 3
+#define CALIB_CACHE_ALIGN(x) (((x) + 63) & ~(unsigned long long)63)
+typedef struct tagCalibCacheHeader
+{
+    char magic[8];                      //"VELOCALB"
+    unsigned int version;
+    unsigned int correction_size;       //sizeof(LaserCorrection)
+    unsigned int laser_num;
+    unsigned long long xml_size;
+    unsigned long long xml_hash;
+    unsigned long long file_size;
+    unsigned long long in_param_offset;
+    unsigned long long scan_table_offset;
+    unsigned long long extrinsic_offset;
+    unsigned long long checksum;        //hashBytes() of everything after the header
+}CalibCacheHeader;
+
+//FNV-1a over 64 bit words, the tail byte by byte
+static unsigned long long hashBytes(const void * data, size_t size)
+{
+    const unsigned long long prime = 1099511628211ULL;
+    unsigned long long hash = 14695981039346656037ULL;
+    const unsigned char * p = (const unsigned char *)data;
+    size_t i = 0;
+    for(; i + 8 <= size; i += 8)
+    {
+        unsigned long long word;
+        memcpy(&word,p + i,8);
+        hash = (hash ^ word) * prime;
+    }
+    for(; i < size; i++)
+    {
+        hash = (hash ^ p[i]) * prime;
+    }
+    return hash;
+}
+
+//hash and size of a whole file, 0 when it can not be read
+static int hashFile(const char * file_dir, unsigned long long & hash, unsigned long long & size)
+{
+    FILE * fp = fopen(file_dir,"rb");
+    if(fp == nullptr)
+    {
+        return 0;
+    }
+    fseek(fp,0,SEEK_END);
+    long length = ftell(fp);
+    fseek(fp,0,SEEK_SET);
+    if(length < 0)
+    {
+        fclose(fp);
+        return 0;
+    }
+    char * buf = new char[length + 1];
+    size_t read_size = fread(buf,1,length,fp);
+    fclose(fp);
+    hash = hashBytes(buf,read_size);
+    size = read_size;
+    delete [] buf;
+    return read_size == (size_t)length;
+}
+
+//extrinsic of position (m) and roll, pitch, yaw (degree): R = Rz(yaw) * Ry(pitch) * Rx(roll)
+static void extrinsicFromPose(const double position[3], const double rpy[3], Extrinsic & extrinsic)
+{
+    double cr = cos(rpy[0] * M_PI / 180.0), sr = sin(rpy[0] * M_PI / 180.0);
+    double cp = cos(rpy[1] * M_PI / 180.0), sp = sin(rpy[1] * M_PI / 180.0);
+    double cy = cos(rpy[2] * M_PI / 180.0), sy = sin(rpy[2] * M_PI / 180.0);
+    double rotation[3][3] =
+    {
+        {cy * cp, cy * sp * sr - sy * cr, cy * sp * cr + sy * sr},
+        {sy * cp, sy * sp * sr + cy * cr, sy * sp * cr - cy * sr},
+        {-sp,     cp * sr,                cp * cr}
+    };
+    memcpy(extrinsic.rotation,rotation,sizeof(rotation));
+    for(int i = 0; i < 3; i++)
+    {
+        extrinsic.translation[i] = position[i] * 100;
+    }
+}
+
+template <typename Real>
+static CloudXYZIT<Real> * createCloud(unsigned int max_point_num)
+{
+    CloudXYZIT<Real> * cloud = new CloudXYZIT<Real>;
+    cloud->point_num = 0;
+    cloud->max_point_num = max_point_num;
+    cloud->x = new Real[max_point_num];
+    cloud->y = new Real[max_point_num];
+    cloud->z = new Real[max_point_num];
+    cloud->intensity = new unsigned char[max_point_num];
+    cloud->line_id = new unsigned char[max_point_num];
+    return cloud;
+}
+
+template <typename Real>
+static void freeCloud(CloudXYZIT<Real> * cloud)
+{
+    if(cloud != nullptr)
+    {
+        delete [] cloud->x;
+        delete [] cloud->y;
+        delete [] cloud->z;
+        delete [] cloud->intensity;
+        delete [] cloud->line_id;
+        delete cloud;
+    }
+}
+
+template <typename Real>
+VeloCalibT<Real>::VeloCalibT(char *calib_file_dir, const char *cache_file_dir, bool print_param)
 {
+    variableInit();
+    this->print_param = print_param;
+    if(cache_file_dir != nullptr && loadCache(calib_file_dir,cache_file_dir))
+    {
+        createCoeff();
+        calib_valid = true;
+        return;
+    }
     if(!readFile(calib_file_dir))
     {
+        printf("ERRO:calibration %s is not read, the lasers are left uncorrected\n",calib_file_dir);
         return;
     }
-    variableInit();
-    createTable();
+    createCoeff();
+    calib_valid = true;
     quickSort(scan_table,0,LASER_NUM-1);
+    if(cache_file_dir != nullptr)
+    {
+        saveCache(calib_file_dir,cache_file_dir);
+    }
 //    for(int i=0;i<LASER_NUM;i++)
 //    {
 //        printf("laser:%d,vert:%f\n",(int)scan_table[i].x,scan_table[i].y);
 //    }
 }
 
-VeloCalib::~VeloCalib()
+template <typename Real>
+VeloCalibT<Real>::~VeloCalibT()
 {
     variableFree();
 }
 
+template <typename Real>
+void VeloCalibT<Real>::variableInit()
+{
+    memset(in_param,0,sizeof(in_param));
+    //cache line aligned, new does not align beyond 16 bytes
+    void * buf = nullptr;
+    if(posix_memalign(&buf,64,sizeof(LaserCoeffT<Real>)) != 0)
+    {
+        buf = nullptr;
+    }
+    laser_coeff = (LaserCoeffT<Real> *)buf;
+    memset(laser_coeff,0,sizeof(LaserCoeffT<Real>));
+    buf = nullptr;
+    if(posix_memalign(&buf,64,2 * sizeof(LaserCoeffInt)) != 0)
+    {
+        buf = nullptr;
+    }
+    int_coeff = (LaserCoeffInt_ptr)buf;
+    memset(int_coeff,0,2 * sizeof(LaserCoeffInt));
+    two_pt_any = false;
+    memset(&trig_table,0,sizeof(trig_table));
+    cos_rot_table = nullptr;
+    sin_rot_table = nullptr;
+    cos_rot_table_q15 = nullptr;
+    sin_rot_table_q15 = nullptr;
+    print_param = false;
+    const double zero[3] = {0,0,0};
+    extrinsicFromPose(zero,zero,xml_extrinsic);
+    extrinsic = xml_extrinsic;
+    defaultFilter(filter);
+    filter_raw = false;
+    filter_count = FilterCount();
+    chunk_cloud = nullptr;
+    chunk_head = nullptr;
+    chunk_point_num = nullptr;
+    chunk_head_num = nullptr;
+    chunk_offset = nullptr;
+    chunk_count = nullptr;
+    chunk_capacity = 0;
+    job_direct = false;
+    job_block = nullptr;
+    job_compact = nullptr;
+    job_block_num = 0;
+    job_chunk_block_num = 0;
+    job_cloud = nullptr;
+    deskew_segment = nullptr;
+    deskew_segment_num = 0;
+    deskew_ref_time = 0;
+    calib_valid = false;
+    setLevel(CALIB_AUTO);
+    //the tables and the coefficients of the empty calibration, so a failed read leaves a usable object
+    createTable();
+    createCoeff();
+}
+
+template <typename Real>
+void VeloCalibT<Real>::variableFree()
+{
+    free(laser_coeff);
+    laser_coeff = nullptr;
+    free(int_coeff);
+    int_coeff = nullptr;
+    free(trig_table.table);
+    trig_table.table = nullptr;
+    freeCloud(chunk_cloud);
+    chunk_cloud = nullptr;
+    freeCloud(chunk_head);
+    chunk_head = nullptr;
+    delete [] chunk_point_num;
+    delete [] chunk_head_num;
+    delete [] chunk_offset;
+    delete [] chunk_count;
+    chunk_point_num = nullptr;
+    chunk_head_num = nullptr;
+    chunk_offset = nullptr;
+    chunk_count = nullptr;
+    chunk_capacity = 0;
+    delete [] deskew_segment;
+    deskew_segment = nullptr;
+    deskew_segment_num = 0;
+}
+
+CloudXYZI_ptr createCloudXYZI(unsigned int max_point_num)
+{
+    return createCloud<double>(max_point_num);
+}
+
+CloudXYZIf_ptr createCloudXYZIf(unsigned int max_point_num)
+{
+    return createCloud<float>(max_point_num);
+}
+
+void freeCloudXYZI(CloudXYZI_ptr cloud)
+{
+    freeCloud(cloud);
+}
+
+void freeCloudXYZI(CloudXYZIf_ptr cloud)
+{
+    freeCloud(cloud);
+}
+
+template <typename Real>
+static RangeImageT<Real> * createImage(int azimuth_step)
+{
+    if(azimuth_step <= 0 || 36000 % azimuth_step != 0)
+    {
+        printf("ERRO:azimuth step %d of the range image does not divide 36000\n",azimuth_step);
+        return nullptr;
+    }
+    RangeImageT<Real> * image = new RangeImageT<Real>;
+    image->row_num = LASER_NUM;
+    image->column_num = 36000 / azimuth_step;
+    image->azimuth_step = azimuth_step;
+    image->point_num = 0;
+    for(int i = 0; i < LASER_NUM; i++)
+    {
+        image->row_line[i] = i;
+    }
+    size_t cell_num = (size_t)image->row_num * image->column_num;
+    image->range = new Real[cell_num];
+    image->x = new Real[cell_num];
+    image->y = new Real[cell_num];
+    image->z = new Real[cell_num];
+    image->intensity = new unsigned char[cell_num];
+    memset(image->range,0,cell_num * sizeof(Real));
+    return image;
+}
+
+template <typename Real>
+static void freeImage(RangeImageT<Real> * image)
+{
+    if(image != nullptr)
+    {
+        delete [] image->range;
+        delete [] image->x;
+        delete [] image->y;
+        delete [] image->z;
+        delete [] image->intensity;
+        delete image;
+    }
+}
+
+RangeImage_ptr createRangeImage(int azimuth_step)
+{
+    return createImage<double>(azimuth_step);
+}
+
+RangeImagef_ptr createRangeImagef(int azimuth_step)
+{
+    return createImage<float>(azimuth_step);
+}
+
+void freeRangeImage(RangeImage_ptr image)
+{
+    freeImage(image);
+}
+
+void freeRangeImage(RangeImagef_ptr image)
+{
+    freeImage(image);
+}
+
+//column of the azimuth in the fused trig table, rounded to the nearest one
+static inline int trigColumn(const TrigTable & trig, int rot_angle)
+{
+    int column = (rot_angle + trig.azimuth_step / 2) / trig.azimuth_step;
+    return column < trig.column_num ? column : column - trig.column_num;
+}
+
+//cos and sin of the laser at the azimuth from the fused trig table
+template <typename Real>
+static inline void lookupTrig(const TrigTable & trig, int line, int rot_angle, Real & cos_rot_angle, Real & sin_rot_angle)
+{
+    int index = trigColumn(trig,rot_angle) * 2 * LASER_NUM + line;
+    if(trig.format == TRIG_TABLE_FLOAT)
+    {
+        const float * table = (const float *)trig.table;
+        cos_rot_angle = table[index];
+        sin_rot_angle = table[index + LASER_NUM];
+    }
+    else
+    {
+        const short * table = (const short *)trig.table;
+        cos_rot_angle = table[index] * (Real)(1.0 / 32768);
+        sin_rot_angle = table[index + LASER_NUM] * (Real)(1.0 / 32768);
+    }
+}
+
+//1 when the raw rot_angle is inside one of the sectors of the filter
+static inline bool insideSector(const CalibFilter & filter, int rot_angle)
+{
+    if(filter.sector_num == 0)
+    {
+        return true;
+    }
+    for(int i = 0; i < filter.sector_num; i++)
+    {
+        int start = filter.sector_start[i];
+        int end = filter.sector_end[i];
+        if(start <= end ? (rot_angle >= start && rot_angle < end) : (rot_angle >= start || rot_angle < end))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+//raw data rules of the filter on the 32 lasers of one block, bit k set for the kept laser k
+static unsigned int filterBlock(const CalibFilter & filter, FilterCount & count, const unsigned short * distance,
+                                int line_base, unsigned short rot_angle)
+{
+    unsigned int valid = 0;
+    unsigned int in_range = 0;
+    for(int k = 0; k < 32; k++)
+    {
+        valid |= (unsigned int)(distance[k] != 0) << k;
+        in_range |= (unsigned int)(distance[k] >= filter.min_distance && distance[k] <= filter.max_distance) << k;
+    }
+    if(!insideSector(filter,rot_angle))
+    {
+        count.rejected[FILTER_SECTOR] += __builtin_popcount(valid);
+        return 0;
+    }
+    unsigned int laser = (unsigned int)(filter.laser_mask >> line_base);
+    count.rejected[FILTER_LASER] += __builtin_popcount(valid & ~laser);
+    valid &= laser;
+    count.rejected[FILTER_DISTANCE] += __builtin_popcount(valid & ~in_range);
+    return valid & in_range;
+}
+
+//raw data rules of the filter on one point, false when it is rejected or has no distance
+static inline bool filterPoint(const CalibFilter & filter, FilterCount & count, int line_id,
+                               unsigned short rot_angle, unsigned short distance)
+{
+    if(distance == 0)
+    {
+        return false;
+    }
+    int rule = !insideSector(filter,rot_angle) ? FILTER_SECTOR :
+               !((filter.laser_mask >> line_id) & 1) ? FILTER_LASER :
+               (distance < filter.min_distance || distance > filter.max_distance) ? FILTER_DISTANCE : FILTER_RULE_NUM;
+    if(rule == FILTER_RULE_NUM)
+    {
+        return true;
+    }
+    count.rejected[rule] ++;
+    return false;
+}
+
+//1 when the point is inside the box x_min,x_max,y_min,y_max,z_min,z_max
+template <typename T>
+static inline bool insideBox(const T * box, T x, T y, T z)
+{
+    return x >= box[0] && x <= box[1] && y >= box[2] && y <= box[3] && z >= box[4] && z <= box[5];
+}
+
+//region and body rules of the filter on one converted point, false when it is rejected
+template <typename Coeff, typename T>
+static inline bool filterRegion(const Coeff & coeff, FilterCount & count, T x, T y, T z)
+{
+    if(coeff.region_available && !insideBox(coeff.region,x,y,z))
+    {
+        count.rejected[FILTER_REGION] ++;
+        return false;
+    }
+    if(coeff.body_available && insideBox(coeff.body,x,y,z))
+    {
+        count.rejected[FILTER_BODY] ++;
+        return false;
+    }
+    return true;
+}
+
 /**
  * @brief VeloCalib::convLRDI2XYZI converse raw pointLRDI( 2mm )  into Point3FI(cm), calculta in (cm)
+ * with the per laser coefficients of createTable()
+ * @param input_PointLRDI
+ * @param output_Point3FI
+ * @return 0: distance is 0; 1: ok
+ */
+template <typename Real>
+int VeloCalibT<Real>::convLRDI2XYZI(PointLRDI_ptr input_PointLRDI, Point &output_Point3FI)
+{
+    return convPoint(input_PointLRDI,output_Point3FI,laser_coeff->extrinsic_available ? laser_coeff->extrinsic : nullptr);
+}
+
+//convLRDI2XYZI with the transform given, the one of a block under the de-skew
+template <typename Real>
+int VeloCalibT<Real>::convPoint(PointLRDI_ptr input_PointLRDI, Point &output_Point3FI, const Real *extrinsic)
+{
+    if(input_PointLRDI->distance == 0)
+    {
+        return 0;
+    }
+    const LaserCoeffT<Real> & coeff = *laser_coeff;
+    int line = input_PointLRDI->line_id;
+    Real raw_distance = input_PointLRDI->distance;
+    Real cos_rot_angle;
+    Real sin_rot_angle;
+    if(trig_table.format == TRIG_TABLE_OFF)
+    {
+        cos_rot_angle =
+                cos_rot_table[input_PointLRDI->rot_angle] * coeff.cos_rot_correction[line] +
+                sin_rot_table[input_PointLRDI->rot_angle] * coeff.sin_rot_correction[line];
+        sin_rot_angle =
+                sin_rot_table[input_PointLRDI->rot_angle] * coeff.cos_rot_correction[line] -
+                cos_rot_table[input_PointLRDI->rot_angle] * coeff.sin_rot_correction[line];
+    }
+    else
+    {
+        lookupTrig(trig_table,line,input_PointLRDI->rot_angle,cos_rot_angle,sin_rot_angle);
+    }
+    Real horiz_cos = coeff.horiz_offset_correction[line] * cos_rot_angle;
+    Real horiz_sin = coeff.horiz_offset_correction[line] * sin_rot_angle;
+
+    Real xy_distance = raw_distance * coeff.xy_scale[line] + coeff.xy_offset[line];
+    Real xy_distance_x = xy_distance;
+    Real xy_distance_y = xy_distance;
+    Real z = raw_distance * coeff.z_scale[line] + coeff.z_offset[line];
+    if(coeff.two_pt_correction_available[line] != 0)
+    {
+        Real xx = std::fabs(xy_distance * sin_rot_angle - horiz_cos);
+        Real yy = std::fabs(xy_distance * cos_rot_angle + horiz_sin);
+        Real distance_corr_x = xx * coeff.two_pt_slope_x[line] + coeff.two_pt_offset_x[line];
+        Real distance_corr_y = yy * coeff.two_pt_slope_y[line] + coeff.two_pt_offset_y[line];
+        xy_distance_x += distance_corr_x * coeff.cos_vert_correction[line];
+        xy_distance_y += distance_corr_y * coeff.cos_vert_correction[line];
+        z += distance_corr_y * coeff.sin_vert_correction[line];
+    }
+
+    Real range_term = 1 - raw_distance * (Real)(1.0 / 65535);
+    int intensity1 = (int)input_PointLRDI->intensity;
+    int intensity2 = intensity1 + coeff.focal_slope[line] *
+            std::fabs(coeff.focal_offset[line] - 256 * range_term * range_term);
+    if(intensity2 < coeff.min_intensity[line])
+    {
+        intensity2 = coeff.min_intensity[line];
+    }
+    if(intensity1 > coeff.max_intensity[line])
+    {
+        intensity2 = coeff.max_intensity[line];
+    }
+
+    Real x = xy_distance_x * sin_rot_angle - horiz_cos;
+    Real y = xy_distance_y * cos_rot_angle + horiz_sin;
+    if(extrinsic != nullptr)
+    {
+        const Real * e = extrinsic;
+        Real x0 = x;
+        Real y0 = y;
+        x = e[0] * x0 + e[1] * y0 + e[2] * z + e[3];
+        y = e[4] * x0 + e[5] * y0 + e[6] * z + e[7];
+        z = e[8] * x0 + e[9] * y0 + e[10] * z + e[11];
+    }
+    output_Point3FI.x = x;
+    output_Point3FI.y = y;
+    output_Point3FI.z = z;
+    output_Point3FI.intensity = intensity2;
+    return 1;
+}
+
+/**
+ * @brief VeloCalib::convLRDI2XYZIRef the original conversion on the packed in_param,
+ * every per laser term is computed again for each point
  * @param input_PointLRDI
  * @param output_Point3FI
  * @return 0: distance is 0; 1: ok
  */
-int VeloCalib::convLRDI2XYZI(PointLRDI_ptr input_PointLRDI, Point3FI &output_Point3FI)
+template <typename Real>
+int VeloCalibT<Real>::convLRDI2XYZIRef(PointLRDI_ptr input_PointLRDI, Point &output_Point3FI)
 {
     LaserCorrection corrections = in_param[(int)input_PointLRDI->line_id];
     double distance = (double)input_PointLRDI->distance * DISTANCE_RESOLUTION;
@@ -146,105 +649,2143 @@ int VeloCalib::convLRDI2XYZI(PointLRDI_ptr input_PointLRDI, Point3FI &output_Poi
     output_Point3FI.y = y_coord;
     output_Point3FI.z = z_coord;
     output_Point3FI.intensity = intensity2;
+    return 1;
+}
+
+//coefficients of 4 lasers, one per lane
+typedef struct tagLaserLane4
+{
+    __m256d cos_rot_correction;
+    __m256d sin_rot_correction;
+    __m256d horiz_offset_correction;
+    __m256d xy_scale;
+    __m256d xy_offset;
+    __m256d z_scale;
+    __m256d z_offset;
+    __m256d focal_offset;
+    __m256d focal_slope;
+    __m256d min_intensity;
+    __m256d max_intensity;
+    __m256d two_pt_correction_available;
+}LaserLane4;
+
+//lasers base ... base+3, base is a multiple of 4
+__attribute__((target("avx2,fma")))
+static inline void loadLaserLane4(const LaserCoeff & coeff, int base, LaserLane4 & lane)
+{
+    lane.cos_rot_correction = _mm256_load_pd(coeff.cos_rot_correction + base);
+    lane.sin_rot_correction = _mm256_load_pd(coeff.sin_rot_correction + base);
+    lane.horiz_offset_correction = _mm256_load_pd(coeff.horiz_offset_correction + base);
+    lane.xy_scale = _mm256_load_pd(coeff.xy_scale + base);
+    lane.xy_offset = _mm256_load_pd(coeff.xy_offset + base);
+    lane.z_scale = _mm256_load_pd(coeff.z_scale + base);
+    lane.z_offset = _mm256_load_pd(coeff.z_offset + base);
+    lane.focal_offset = _mm256_load_pd(coeff.focal_offset + base);
+    lane.focal_slope = _mm256_load_pd(coeff.focal_slope + base);
+    lane.min_intensity = _mm256_load_pd(coeff.min_intensity + base);
+    lane.max_intensity = _mm256_load_pd(coeff.max_intensity + base);
+    lane.two_pt_correction_available = _mm256_load_pd(coeff.two_pt_correction_available + base);
+}
+
+//any 4 lasers
+__attribute__((target("avx2,fma")))
+static inline void gatherLaserLane4(const LaserCoeff & coeff, __m128i line_id, LaserLane4 & lane)
+{
+    lane.cos_rot_correction = _mm256_i32gather_pd(coeff.cos_rot_correction,line_id,8);
+    lane.sin_rot_correction = _mm256_i32gather_pd(coeff.sin_rot_correction,line_id,8);
+    lane.horiz_offset_correction = _mm256_i32gather_pd(coeff.horiz_offset_correction,line_id,8);
+    lane.xy_scale = _mm256_i32gather_pd(coeff.xy_scale,line_id,8);
+    lane.xy_offset = _mm256_i32gather_pd(coeff.xy_offset,line_id,8);
+    lane.z_scale = _mm256_i32gather_pd(coeff.z_scale,line_id,8);
+    lane.z_offset = _mm256_i32gather_pd(coeff.z_offset,line_id,8);
+    lane.focal_offset = _mm256_i32gather_pd(coeff.focal_offset,line_id,8);
+    lane.focal_slope = _mm256_i32gather_pd(coeff.focal_slope,line_id,8);
+    lane.min_intensity = _mm256_i32gather_pd(coeff.min_intensity,line_id,8);
+    lane.max_intensity = _mm256_i32gather_pd(coeff.max_intensity,line_id,8);
+    lane.two_pt_correction_available = _mm256_i32gather_pd(coeff.two_pt_correction_available,line_id,8);
+}
+
+//lane order of the points kept by each 4 bit mask, as pairs of 32 bit indexes
+static const int compress_table[16][8] =
+{
+    {0,1,2,3,4,5,6,7}, {0,1,2,3,4,5,6,7}, {2,3,0,1,4,5,6,7}, {0,1,2,3,4,5,6,7},
+    {4,5,0,1,2,3,6,7}, {0,1,4,5,2,3,6,7}, {2,3,4,5,0,1,6,7}, {0,1,2,3,4,5,6,7},
+    {6,7,0,1,2,3,4,5}, {0,1,6,7,2,3,4,5}, {2,3,6,7,0,1,4,5}, {0,1,2,3,6,7,4,5},
+    {4,5,6,7,0,1,2,3}, {0,1,4,5,6,7,2,3}, {2,3,4,5,6,7,0,1}, {0,1,2,3,4,5,6,7}
+};
+
+//azimuth of 4 lasers with their rot_correction
+__attribute__((target("avx2,fma")))
+static inline void rotLane4(const LaserLane4 & lane, __m256d cos_rot_table, __m256d sin_rot_table,
+                            __m256d & cos_rot_angle, __m256d & sin_rot_angle)
+{
+    cos_rot_angle = _mm256_fmadd_pd(cos_rot_table,lane.cos_rot_correction,
+                                    _mm256_mul_pd(sin_rot_table,lane.sin_rot_correction));
+    sin_rot_angle = _mm256_fmsub_pd(sin_rot_table,lane.cos_rot_correction,
+                                    _mm256_mul_pd(cos_rot_table,lane.sin_rot_correction));
 }
 
-void VeloCalib::createTable()
+//the same from the fused trig table, 4 lasers from index on
+__attribute__((target("avx2,fma")))
+static inline void loadTrigLane4(const TrigTable & trig, int index, __m256d & cos_rot_angle, __m256d & sin_rot_angle)
 {
-    for(int i=0;i<36000;i++)
+    if(trig.format == TRIG_TABLE_FLOAT)
     {
-        cos_rot_table[i] = cos((double)(i*M_PI/180.0/100.0));
-        sin_rot_table[i] = sin((double)(i*M_PI/180.0/100.0));
+        const float * table = (const float *)trig.table + index;
+        cos_rot_angle = _mm256_cvtps_pd(_mm_loadu_ps(table));
+        sin_rot_angle = _mm256_cvtps_pd(_mm_loadu_ps(table + LASER_NUM));
+        return;
     }
-    for(int i=0;i<LASER_NUM;i++)
+    const short * table = (const short *)trig.table + index;
+    const __m256d scale = _mm256_set1_pd(1.0 / 32768);
+    cos_rot_angle = _mm256_mul_pd(_mm256_cvtepi32_pd(_mm_cvtepi16_epi32(_mm_loadl_epi64((const __m128i *)table))),scale);
+    sin_rot_angle = _mm256_mul_pd(_mm256_cvtepi32_pd(_mm_cvtepi16_epi32(_mm_loadl_epi64((const __m128i *)(table + LASER_NUM)))),scale);
+}
+
+//any 4 entries of the fused trig table
+__attribute__((target("avx2,fma")))
+static inline void gatherTrigLane4(const TrigTable & trig, __m128i index, __m256d & cos_rot_angle, __m256d & sin_rot_angle)
+{
+    __m128i sin_index = _mm_add_epi32(index,_mm_set1_epi32(LASER_NUM));
+    if(trig.format == TRIG_TABLE_FLOAT)
     {
-        in_param[i].cos_rot_correction = cos(M_PI/180.0*in_param[i].rot_correction);
-        in_param[i].cos_vert_correction = cos(M_PI/180.0*in_param[i].vert_correction);
-        in_param[i].sin_vert_correction = sin(M_PI/180.0*in_param[i].vert_correction);
-        in_param[i].sin_rot_correction = sin(M_PI/180.0*in_param[i].rot_correction);
+        const float * table = (const float *)trig.table;
+        cos_rot_angle = _mm256_cvtps_pd(_mm_i32gather_ps(table,index,4));
+        sin_rot_angle = _mm256_cvtps_pd(_mm_i32gather_ps(table,sin_index,4));
+        return;
     }
+    //32 bits at each int16, the upper half is dropped
+    const int * table = (const int *)trig.table;
+    const __m256d scale = _mm256_set1_pd(1.0 / 32768);
+    __m128i cos16 = _mm_srai_epi32(_mm_slli_epi32(_mm_i32gather_epi32(table,index,2),16),16);
+    __m128i sin16 = _mm_srai_epi32(_mm_slli_epi32(_mm_i32gather_epi32(table,sin_index,2),16),16);
+    cos_rot_angle = _mm256_mul_pd(_mm256_cvtepi32_pd(cos16),scale);
+    sin_rot_angle = _mm256_mul_pd(_mm256_cvtepi32_pd(sin16),scale);
 }
 
-int VeloCalib::readFile(char *file_dir)
+//extrinsic transform of 4 points
+__attribute__((target("avx2,fma")))
+static inline void transformLane4(const double * e, __m256d & x, __m256d & y, __m256d & z)
 {
-    tinyxml2::XMLDocument* doc = new tinyxml2::XMLDocument();
-    doc->LoadFile( file_dir );
-    int erro_id = doc->ErrorID();
-    if(erro_id==tinyxml2::XML_SUCCESS)
+    __m256d x0 = x;
+    __m256d y0 = y;
+    __m256d z0 = z;
+    x = _mm256_fmadd_pd(_mm256_set1_pd(e[0]),x0,_mm256_fmadd_pd(_mm256_set1_pd(e[1]),y0,
+                        _mm256_fmadd_pd(_mm256_set1_pd(e[2]),z0,_mm256_set1_pd(e[3]))));
+    y = _mm256_fmadd_pd(_mm256_set1_pd(e[4]),x0,_mm256_fmadd_pd(_mm256_set1_pd(e[5]),y0,
+                        _mm256_fmadd_pd(_mm256_set1_pd(e[6]),z0,_mm256_set1_pd(e[7]))));
+    z = _mm256_fmadd_pd(_mm256_set1_pd(e[8]),x0,_mm256_fmadd_pd(_mm256_set1_pd(e[9]),y0,
+                        _mm256_fmadd_pd(_mm256_set1_pd(e[10]),z0,_mm256_set1_pd(e[11]))));
+}
+
+//bit k set for the lanes inside the box x_min,x_max,y_min,y_max,z_min,z_max
+__attribute__((target("avx2,fma")))
+static inline int insideBoxLane4(const double * box, __m256d x, __m256d y, __m256d z)
+{
+    __m256d inside = _mm256_and_pd(_mm256_cmp_pd(x,_mm256_set1_pd(box[0]),_CMP_GE_OQ),_mm256_cmp_pd(x,_mm256_set1_pd(box[1]),_CMP_LE_OQ));
+    inside = _mm256_and_pd(inside,_mm256_and_pd(_mm256_cmp_pd(y,_mm256_set1_pd(box[2]),_CMP_GE_OQ),_mm256_cmp_pd(y,_mm256_set1_pd(box[3]),_CMP_LE_OQ)));
+    inside = _mm256_and_pd(inside,_mm256_and_pd(_mm256_cmp_pd(z,_mm256_set1_pd(box[4]),_CMP_GE_OQ),_mm256_cmp_pd(z,_mm256_set1_pd(box[5]),_CMP_LE_OQ)));
+    return _mm256_movemask_pd(inside);
+}
+
+//filterRegion on the kept lanes, returns the lanes still kept
+__attribute__((target("avx2,fma")))
+static inline int filterRegionLane4(const LaserCoeff & coeff, FilterCount & count, __m256d x, __m256d y, __m256d z, int keep)
+{
+    if(coeff.region_available)
     {
-        printf("LOG:XML_SUCCESS\n");
+        int inside = insideBoxLane4(coeff.region,x,y,z);
+        count.rejected[FILTER_REGION] += __builtin_popcount(keep & ~inside);
+        keep &= inside;
     }
-    if(erro_id==tinyxml2::XML_ERROR_FILE_NOT_FOUND)
+    if(coeff.body_available)
     {
-        printf("ERO:XML_ERROR_FILE_NOT_FOUND\n");
-        return 0;
+        int inside = insideBoxLane4(coeff.body,x,y,z);
+        count.rejected[FILTER_BODY] += __builtin_popcount(keep & inside);
+        keep &= ~inside;
     }
-    if(erro_id==tinyxml2::XML_ERROR_FILE_COULD_NOT_BE_OPENED)
+    return keep;
+}
+
+/** @brief the math of convLRDI2XYZI on 4 points, then the points with a distance
+ *  are packed to the end of the cloud, which must have room for 4 more
+ *  @param raw distance (2mm), raw intensity, line id, cos and sin of the azimuth with rot_correction,
+ *  lanes kept by the raw data rules of the filter and its counters
+ */
+__attribute__((target("avx2,fma")))
+static inline void convLane4(const LaserCoeff & coeff, const LaserLane4 & lane, __m256d raw_distance, __m256d raw_intensity,
+                             __m128i line_id, __m256d cos_rot_angle, __m256d sin_rot_angle, const double * extrinsic,
+                             int keep, FilterCount & count, CloudXYZI & cloud)
+{
+    keep &= _mm256_movemask_pd(_mm256_cmp_pd(raw_distance,_mm256_setzero_pd(),_CMP_NEQ_OQ));
+    if(keep == 0)
     {
-        printf("ERO:XML_ERROR_FILE_COULD_NOT_BE_OPENED\n");
-        return 0;
+        return;
     }
-    if(erro_id==tinyxml2::XML_ERROR_FILE_READ_ERROR)
+    __m256d horiz_cos = _mm256_mul_pd(lane.horiz_offset_correction,cos_rot_angle);
+    __m256d horiz_sin = _mm256_mul_pd(lane.horiz_offset_correction,sin_rot_angle);
+    __m256d xy_distance = _mm256_fmadd_pd(raw_distance,lane.xy_scale,lane.xy_offset);
+    __m256d xy_distance_x = xy_distance;
+    __m256d xy_distance_y = xy_distance;
+    __m256d z = _mm256_fmadd_pd(raw_distance,lane.z_scale,lane.z_offset);
+
+    //two points distance correction, linear in |x| and |y|, rare enough to gather its coefficients
+    __m256d two_pt = _mm256_cmp_pd(lane.two_pt_correction_available,_mm256_setzero_pd(),_CMP_NEQ_OQ);
+    if(_mm256_movemask_pd(two_pt))
     {
-        printf("ERO:XML_ERROR_FILE_READ_ERROR\n");
-        return 0;
+        const __m256d sign_mask = _mm256_set1_pd(-0.0);
+        __m128i line = line_id;
+        __m256d xx = _mm256_andnot_pd(sign_mask,_mm256_fmsub_pd(xy_distance,sin_rot_angle,horiz_cos));
+        __m256d yy = _mm256_andnot_pd(sign_mask,_mm256_fmadd_pd(xy_distance,cos_rot_angle,horiz_sin));
+        __m256d corr_x = _mm256_and_pd(two_pt,_mm256_fmadd_pd(xx,_mm256_i32gather_pd(coeff.two_pt_slope_x,line,8),
+                                                              _mm256_i32gather_pd(coeff.two_pt_offset_x,line,8)));
+        __m256d corr_y = _mm256_and_pd(two_pt,_mm256_fmadd_pd(yy,_mm256_i32gather_pd(coeff.two_pt_slope_y,line,8),
+                                                              _mm256_i32gather_pd(coeff.two_pt_offset_y,line,8)));
+        __m256d cos_vert = _mm256_i32gather_pd(coeff.cos_vert_correction,line,8);
+        xy_distance_x = _mm256_fmadd_pd(corr_x,cos_vert,xy_distance);
+        xy_distance_y = _mm256_fmadd_pd(corr_y,cos_vert,xy_distance);
+        z = _mm256_fmadd_pd(corr_y,_mm256_i32gather_pd(coeff.sin_vert_correction,line,8),z);
     }
-    tinyxml2::XMLElement * db = doc->RootElement()->FirstChildElement("DB");
-    tinyxml2::XMLElement * min_intensity = db->FirstChildElement("minIntensity_")->FirstChildElement("item");
-    tinyxml2::XMLElement * max_intensity = db->FirstChildElement("maxIntensity_")->FirstChildElement("item");
-    tinyxml2::XMLElement * points = db->FirstChildElement("points_")->FirstChildElement("item");
-    for(int i=0;i<LASER_NUM;i++)
+    __m256d x = _mm256_fmsub_pd(xy_distance_x,sin_rot_angle,horiz_cos);
+    __m256d y = _mm256_fmadd_pd(xy_distance_y,cos_rot_angle,horiz_sin);
+    if(extrinsic != nullptr)
     {
-        printf("laser:%d \n",i);
-        in_param[i].min_intensity = min_intensity->IntText();
-        printf("min_i:%03d ",in_param[i].min_intensity);
-        in_param[i].max_intensity = max_intensity->IntText();
-        printf("max_i:%03d ",in_param[i].max_intensity);
-        in_param[i].rot_correction = points->FirstChild()->
-                FirstChildElement("rotCorrection_")->DoubleText();
-        printf("rot_corr:%.3f ",in_param[i].rot_correction);
-        in_param[i].vert_correction = points->FirstChild()->
-                FirstChildElement("vertCorrection_")->DoubleText();
-        printf("vert_corr:%.3f ",in_param[i].vert_correction);
-        in_param[i].dist_correction = points->FirstChild()->
-                FirstChildElement("distCorrection_")->DoubleText();
-        printf("dist_corr:%.3f ",in_param[i].dist_correction);
-        in_param[i].dist_correction_x = points->FirstChild()->
-                FirstChildElement("distCorrectionX_")->DoubleText();
-        printf("dist_corr_x:%.3f ",in_param[i].dist_correction_x);
-        in_param[i].dist_correction_y = points->FirstChild()->
-                FirstChildElement("distCorrectionY_")->DoubleText();
-        printf("dist_corr_y:%.3f ",in_param[i].dist_correction_y);
-        in_param[i].vert_offset_correction = points->FirstChild()->
-                FirstChildElement("vertOffsetCorrection_")->DoubleText();
-        printf("vert_offset:%.3f ",in_param[i].vert_offset_correction);
-        in_param[i].horiz_offset_correction = points->FirstChild()->
-                FirstChildElement("horizOffsetCorrection_")->DoubleText();
-        printf("horiz_offset:%.3f ",in_param[i].horiz_offset_correction);
-        in_param[i].focal_distance = points->FirstChild()->
-                FirstChildElement("focalDistance_")->DoubleText();
-        printf("focal_dist:%.3f ",in_param[i].focal_distance);
-        in_param[i].focal_slope = points->FirstChild()->
-                FirstChildElement("focalSlope_")->DoubleText();
-        printf("focal_slope:%.3f\n",in_param[i].focal_slope);
+        transformLane4(extrinsic,x,y,z);
+    }
+    if(coeff.region_available || coeff.body_available)
+    {
+        keep = filterRegionLane4(coeff,count,x,y,z,keep);
+        if(keep == 0)
+        {
+            return;
+        }
+    }
 
-        in_param[i].two_pt_correction_available = false;
-        scan_table[i].x = i;
-        scan_table[i].y = in_param[i].vert_correction;
+    //intensity with the focal distance correction
+    __m256d range_term = _mm256_fnmadd_pd(raw_distance,_mm256_set1_pd(1.0 / 65535),_mm256_set1_pd(1.0));
+    __m256d range_offset = _mm256_mul_pd(_mm256_mul_pd(_mm256_set1_pd(256),range_term),range_term);
+    __m256d focal_gap = _mm256_andnot_pd(_mm256_set1_pd(-0.0),_mm256_sub_pd(lane.focal_offset,range_offset));
+    __m128i intensity = _mm256_cvttpd_epi32(_mm256_fmadd_pd(lane.focal_slope,focal_gap,raw_intensity));
+    intensity = _mm_max_epi32(intensity,_mm256_cvttpd_epi32(lane.min_intensity));
+    __m128i max_intensity = _mm256_cvttpd_epi32(lane.max_intensity);
+    intensity = _mm_blendv_epi8(intensity,max_intensity,_mm_cmpgt_epi32(_mm256_cvttpd_epi32(raw_intensity),max_intensity));
 
-        min_intensity = min_intensity->NextSiblingElement();
-        max_intensity = max_intensity->NextSiblingElement();
-        points = points->NextSiblingElement();
+    //pack the kept points to the front and store all 4 lanes, the cloud only advances by the kept ones
+    __m256i order = _mm256_loadu_si256((const __m256i *)compress_table[keep]);
+    unsigned int n = cloud.point_num;
+    _mm256_storeu_pd(cloud.x + n,_mm256_castps_pd(_mm256_permutevar8x32_ps(_mm256_castpd_ps(x),order)));
+    _mm256_storeu_pd(cloud.y + n,_mm256_castps_pd(_mm256_permutevar8x32_ps(_mm256_castpd_ps(y),order)));
+    _mm256_storeu_pd(cloud.z + n,_mm256_castps_pd(_mm256_permutevar8x32_ps(_mm256_castpd_ps(z),order)));
+    int intensity_lane[4];
+    int line_lane[4];
+    _mm_storeu_si128((__m128i *)intensity_lane,intensity);
+    _mm_storeu_si128((__m128i *)line_lane,line_id);
+    while(keep)
+    {
+        int k = __builtin_ctz(keep);
+        cloud.intensity[n] = (unsigned char)intensity_lane[k];
+        cloud.line_id[n] = (unsigned char)line_lane[k];
+        n ++;
+        keep &= keep - 1;
     }
-    delete doc;
-    return 1;
+    cloud.point_num = n;
 }
 
-void VeloCalib::quickSort(Point2F *s, int l, int r)
+//32 lasers of one block, the cloud must have room for 32 more, bit k of keep for laser k
+__attribute__((target("avx2,fma")))
+static void convBlockAVX2(const LaserCoeff & coeff, const double * cos_rot_table, const double * sin_rot_table,
+                          const TrigTable & trig, const unsigned short * distance, const unsigned char * intensity,
+                          int line_base, unsigned short rot_angle, const double * extrinsic, unsigned int keep,
+                          FilterCount & count, CloudXYZI & cloud)
 {
-    if (l < r)
+    __m256d cos_rot = _mm256_set1_pd(cos_rot_table[rot_angle]);
+    __m256d sin_rot = _mm256_set1_pd(sin_rot_table[rot_angle]);
+    int trig_index = trig.format == TRIG_TABLE_OFF ? 0 : trigColumn(trig,rot_angle) * 2 * LASER_NUM + line_base;
+    LaserLane4 lane;
+    __m256d cos_rot_angle;
+    __m256d sin_rot_angle;
+    for(int k = 0; k < 32; k += 4)
     {
-        int i = l, j = r;
-        Point2F x = s[l];
+        int keep4 = (keep >> k) & 15;
+        if(keep4 == 0)
+        {
+            continue;
+        }
+        __m256d raw_distance = _mm256_cvtepi32_pd(_mm_cvtepu16_epi32(_mm_loadl_epi64((const __m128i *)(distance + k))));
+        int intensity4;
+        memcpy(&intensity4,intensity + k,4);
+        __m256d raw_intensity = _mm256_cvtepi32_pd(_mm_cvtepu8_epi32(_mm_cvtsi32_si128(intensity4)));
+        __m128i line_id = _mm_add_epi32(_mm_set1_epi32(line_base + k),_mm_setr_epi32(0,1,2,3));
+        loadLaserLane4(coeff,line_base + k,lane);
+        if(trig.format == TRIG_TABLE_OFF)
+        {
+            rotLane4(lane,cos_rot,sin_rot,cos_rot_angle,sin_rot_angle);
+        }
+        else
+        {
+            loadTrigLane4(trig,trig_index + k,cos_rot_angle,sin_rot_angle);
+        }
+        convLane4(coeff,lane,raw_distance,raw_intensity,line_id,cos_rot_angle,sin_rot_angle,extrinsic,keep4,count,cloud);
+    }
+}
+
+//num points given as arrays, returns the points done, the rest does not fit into 4 lanes or the cloud.
+//filter is nullptr when its raw data rules are off
+__attribute__((target("avx2,fma")))
+static int convPointsAVX2(const LaserCoeff & coeff, const double * cos_rot_table, const double * sin_rot_table,
+                          const TrigTable & trig, const unsigned char * line_id, const unsigned short * rot_angle,
+                          const unsigned short * distance, const unsigned char * intensity,
+                          int num, const CalibFilter * filter, FilterCount & count, CloudXYZI & cloud)
+{
+    LaserLane4 lane;
+    __m256d cos_rot_angle;
+    __m256d sin_rot_angle;
+    int trig_index[4];
+    int i = 0;
+    for(; i + 4 <= num && cloud.point_num + 4 <= cloud.max_point_num; i += 4)
+    {
+        int keep = 15;
+        if(filter != nullptr)
+        {
+            keep = 0;
+            for(int k = 0; k < 4; k++)
+            {
+                keep |= (int)filterPoint(*filter,count,line_id[i + k],rot_angle[i + k],distance[i + k]) << k;
+            }
+            if(keep == 0)
+            {
+                continue;
+            }
+        }
+        __m256d raw_distance = _mm256_cvtepi32_pd(_mm_cvtepu16_epi32(_mm_loadl_epi64((const __m128i *)(distance + i))));
+        int bytes4;
+        memcpy(&bytes4,intensity + i,4);
+        __m256d raw_intensity = _mm256_cvtepi32_pd(_mm_cvtepu8_epi32(_mm_cvtsi32_si128(bytes4)));
+        memcpy(&bytes4,line_id + i,4);
+        __m128i line4 = _mm_cvtepu8_epi32(_mm_cvtsi32_si128(bytes4));
+        __m128i rot4 = _mm_cvtepu16_epi32(_mm_loadl_epi64((const __m128i *)(rot_angle + i)));
+        gatherLaserLane4(coeff,line4,lane);
+        if(trig.format == TRIG_TABLE_OFF)
+        {
+            rotLane4(lane,_mm256_i32gather_pd(cos_rot_table,rot4,8),_mm256_i32gather_pd(sin_rot_table,rot4,8),
+                     cos_rot_angle,sin_rot_angle);
+        }
+        else
+        {
+            for(int k = 0; k < 4; k++)
+            {
+                trig_index[k] = trigColumn(trig,rot_angle[i + k]) * 2 * LASER_NUM + line_id[i + k];
+            }
+            gatherTrigLane4(trig,_mm_loadu_si128((const __m128i *)trig_index),cos_rot_angle,sin_rot_angle);
+        }
+        convLane4(coeff,lane,raw_distance,raw_intensity,line4,cos_rot_angle,sin_rot_angle,
+                  coeff.extrinsic_available ? coeff.extrinsic : nullptr,keep,count,cloud);
+    }
+    return i;
+}
+
+//coefficients of 8 lasers for the single precision kernels
+typedef struct tagLaserLane8
+{
+    __m256 cos_rot_correction;
+    __m256 sin_rot_correction;
+    __m256 horiz_offset_correction;
+    __m256 xy_scale;
+    __m256 xy_offset;
+    __m256 z_scale;
+    __m256 z_offset;
+    __m256 focal_offset;
+    __m256 focal_slope;
+    __m256 min_intensity;
+    __m256 max_intensity;
+    __m256 two_pt_correction_available;
+}LaserLane8;
+
+//lasers base ... base+7, base is a multiple of 8
+__attribute__((target("avx2,fma")))
+static inline void loadLaserLane8(const LaserCoeffT<float> & coeff, int base, LaserLane8 & lane)
+{
+    lane.cos_rot_correction = _mm256_load_ps(coeff.cos_rot_correction + base);
+    lane.sin_rot_correction = _mm256_load_ps(coeff.sin_rot_correction + base);
+    lane.horiz_offset_correction = _mm256_load_ps(coeff.horiz_offset_correction + base);
+    lane.xy_scale = _mm256_load_ps(coeff.xy_scale + base);
+    lane.xy_offset = _mm256_load_ps(coeff.xy_offset + base);
+    lane.z_scale = _mm256_load_ps(coeff.z_scale + base);
+    lane.z_offset = _mm256_load_ps(coeff.z_offset + base);
+    lane.focal_offset = _mm256_load_ps(coeff.focal_offset + base);
+    lane.focal_slope = _mm256_load_ps(coeff.focal_slope + base);
+    lane.min_intensity = _mm256_load_ps(coeff.min_intensity + base);
+    lane.max_intensity = _mm256_load_ps(coeff.max_intensity + base);
+    lane.two_pt_correction_available = _mm256_load_ps(coeff.two_pt_correction_available + base);
+}
+
+//any 8 lasers
+__attribute__((target("avx2,fma")))
+static inline void gatherLaserLane8(const LaserCoeffT<float> & coeff, __m256i line_id, LaserLane8 & lane)
+{
+    lane.cos_rot_correction = _mm256_i32gather_ps(coeff.cos_rot_correction,line_id,4);
+    lane.sin_rot_correction = _mm256_i32gather_ps(coeff.sin_rot_correction,line_id,4);
+    lane.horiz_offset_correction = _mm256_i32gather_ps(coeff.horiz_offset_correction,line_id,4);
+    lane.xy_scale = _mm256_i32gather_ps(coeff.xy_scale,line_id,4);
+    lane.xy_offset = _mm256_i32gather_ps(coeff.xy_offset,line_id,4);
+    lane.z_scale = _mm256_i32gather_ps(coeff.z_scale,line_id,4);
+    lane.z_offset = _mm256_i32gather_ps(coeff.z_offset,line_id,4);
+    lane.focal_offset = _mm256_i32gather_ps(coeff.focal_offset,line_id,4);
+    lane.focal_slope = _mm256_i32gather_ps(coeff.focal_slope,line_id,4);
+    lane.min_intensity = _mm256_i32gather_ps(coeff.min_intensity,line_id,4);
+    lane.max_intensity = _mm256_i32gather_ps(coeff.max_intensity,line_id,4);
+    lane.two_pt_correction_available = _mm256_i32gather_ps(coeff.two_pt_correction_available,line_id,4);
+}
+
+//lane order of the points kept by each 8 bit mask, kept lanes first
+struct CompressTable8
+{
+    unsigned char order[256][8];
+    CompressTable8()
+    {
+        for(int mask = 0; mask < 256; mask++)
+        {
+            int n = 0;
+            for(int k = 0; k < 8; k++)
+            {
+                if(mask & (1 << k))
+                {
+                    order[mask][n++] = k;
+                }
+            }
+            for(int k = 0; k < 8; k++)
+            {
+                if(!(mask & (1 << k)))
+                {
+                    order[mask][n++] = k;
+                }
+            }
+        }
+    }
+};
+static const CompressTable8 compress_table8;
+
+//rotLane4, loadTrigLane4 and gatherTrigLane4 on 8 lasers
+__attribute__((target("avx2,fma")))
+static inline void rotLane8(const LaserLane8 & lane, __m256 cos_rot_table, __m256 sin_rot_table,
+                            __m256 & cos_rot_angle, __m256 & sin_rot_angle)
+{
+    cos_rot_angle = _mm256_fmadd_ps(cos_rot_table,lane.cos_rot_correction,
+                                    _mm256_mul_ps(sin_rot_table,lane.sin_rot_correction));
+    sin_rot_angle = _mm256_fmsub_ps(sin_rot_table,lane.cos_rot_correction,
+                                    _mm256_mul_ps(cos_rot_table,lane.sin_rot_correction));
+}
+
+__attribute__((target("avx2,fma")))
+static inline void loadTrigLane8(const TrigTable & trig, int index, __m256 & cos_rot_angle, __m256 & sin_rot_angle)
+{
+    if(trig.format == TRIG_TABLE_FLOAT)
+    {
+        const float * table = (const float *)trig.table + index;
+        cos_rot_angle = _mm256_loadu_ps(table);
+        sin_rot_angle = _mm256_loadu_ps(table + LASER_NUM);
+        return;
+    }
+    const short * table = (const short *)trig.table + index;
+    const __m256 scale = _mm256_set1_ps((float)(1.0 / 32768));
+    cos_rot_angle = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i *)table))),scale);
+    sin_rot_angle = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i *)(table + LASER_NUM)))),scale);
+}
+
+__attribute__((target("avx2,fma")))
+static inline void gatherTrigLane8(const TrigTable & trig, __m256i index, __m256 & cos_rot_angle, __m256 & sin_rot_angle)
+{
+    __m256i sin_index = _mm256_add_epi32(index,_mm256_set1_epi32(LASER_NUM));
+    if(trig.format == TRIG_TABLE_FLOAT)
+    {
+        const float * table = (const float *)trig.table;
+        cos_rot_angle = _mm256_i32gather_ps(table,index,4);
+        sin_rot_angle = _mm256_i32gather_ps(table,sin_index,4);
+        return;
+    }
+    const int * table = (const int *)trig.table;
+    const __m256 scale = _mm256_set1_ps((float)(1.0 / 32768));
+    __m256i cos16 = _mm256_srai_epi32(_mm256_slli_epi32(_mm256_i32gather_epi32(table,index,2),16),16);
+    __m256i sin16 = _mm256_srai_epi32(_mm256_slli_epi32(_mm256_i32gather_epi32(table,sin_index,2),16),16);
+    cos_rot_angle = _mm256_mul_ps(_mm256_cvtepi32_ps(cos16),scale);
+    sin_rot_angle = _mm256_mul_ps(_mm256_cvtepi32_ps(sin16),scale);
+}
+
+__attribute__((target("avx2,fma")))
+static inline void transformLane8(const float * e, __m256 & x, __m256 & y, __m256 & z)
+{
+    __m256 x0 = x;
+    __m256 y0 = y;
+    __m256 z0 = z;
+    x = _mm256_fmadd_ps(_mm256_set1_ps(e[0]),x0,_mm256_fmadd_ps(_mm256_set1_ps(e[1]),y0,
+                        _mm256_fmadd_ps(_mm256_set1_ps(e[2]),z0,_mm256_set1_ps(e[3]))));
+    y = _mm256_fmadd_ps(_mm256_set1_ps(e[4]),x0,_mm256_fmadd_ps(_mm256_set1_ps(e[5]),y0,
+                        _mm256_fmadd_ps(_mm256_set1_ps(e[6]),z0,_mm256_set1_ps(e[7]))));
+    z = _mm256_fmadd_ps(_mm256_set1_ps(e[8]),x0,_mm256_fmadd_ps(_mm256_set1_ps(e[9]),y0,
+                        _mm256_fmadd_ps(_mm256_set1_ps(e[10]),z0,_mm256_set1_ps(e[11]))));
+}
+
+__attribute__((target("avx2,fma")))
+static inline int insideBoxLane8(const float * box, __m256 x, __m256 y, __m256 z)
+{
+    __m256 inside = _mm256_and_ps(_mm256_cmp_ps(x,_mm256_set1_ps(box[0]),_CMP_GE_OQ),_mm256_cmp_ps(x,_mm256_set1_ps(box[1]),_CMP_LE_OQ));
+    inside = _mm256_and_ps(inside,_mm256_and_ps(_mm256_cmp_ps(y,_mm256_set1_ps(box[2]),_CMP_GE_OQ),_mm256_cmp_ps(y,_mm256_set1_ps(box[3]),_CMP_LE_OQ)));
+    inside = _mm256_and_ps(inside,_mm256_and_ps(_mm256_cmp_ps(z,_mm256_set1_ps(box[4]),_CMP_GE_OQ),_mm256_cmp_ps(z,_mm256_set1_ps(box[5]),_CMP_LE_OQ)));
+    return _mm256_movemask_ps(inside);
+}
+
+__attribute__((target("avx2,fma")))
+static inline int filterRegionLane8(const LaserCoeffT<float> & coeff, FilterCount & count, __m256 x, __m256 y, __m256 z, int keep)
+{
+    if(coeff.region_available)
+    {
+        int inside = insideBoxLane8(coeff.region,x,y,z);
+        count.rejected[FILTER_REGION] += __builtin_popcount(keep & ~inside);
+        keep &= inside;
+    }
+    if(coeff.body_available)
+    {
+        int inside = insideBoxLane8(coeff.body,x,y,z);
+        count.rejected[FILTER_BODY] += __builtin_popcount(keep & inside);
+        keep &= ~inside;
+    }
+    return keep;
+}
+
+//convLane4 on 8 points in single precision, the cloud must have room for 8 more
+__attribute__((target("avx2,fma")))
+static inline void convLane8(const LaserCoeffT<float> & coeff, const LaserLane8 & lane, __m256 raw_distance, __m256 raw_intensity,
+                             __m256i line_id, __m256 cos_rot_angle, __m256 sin_rot_angle, const float * extrinsic,
+                             int keep, FilterCount & count, CloudXYZIf & cloud)
+{
+    keep &= _mm256_movemask_ps(_mm256_cmp_ps(raw_distance,_mm256_setzero_ps(),_CMP_NEQ_OQ));
+    if(keep == 0)
+    {
+        return;
+    }
+    __m256 horiz_cos = _mm256_mul_ps(lane.horiz_offset_correction,cos_rot_angle);
+    __m256 horiz_sin = _mm256_mul_ps(lane.horiz_offset_correction,sin_rot_angle);
+    __m256 xy_distance = _mm256_fmadd_ps(raw_distance,lane.xy_scale,lane.xy_offset);
+    __m256 xy_distance_x = xy_distance;
+    __m256 xy_distance_y = xy_distance;
+    __m256 z = _mm256_fmadd_ps(raw_distance,lane.z_scale,lane.z_offset);
+
+    __m256 two_pt = _mm256_cmp_ps(lane.two_pt_correction_available,_mm256_setzero_ps(),_CMP_NEQ_OQ);
+    if(_mm256_movemask_ps(two_pt))
+    {
+        const __m256 sign_mask = _mm256_set1_ps(-0.0f);
+        __m256 xx = _mm256_andnot_ps(sign_mask,_mm256_fmsub_ps(xy_distance,sin_rot_angle,horiz_cos));
+        __m256 yy = _mm256_andnot_ps(sign_mask,_mm256_fmadd_ps(xy_distance,cos_rot_angle,horiz_sin));
+        __m256 corr_x = _mm256_and_ps(two_pt,_mm256_fmadd_ps(xx,_mm256_i32gather_ps(coeff.two_pt_slope_x,line_id,4),
+                                                             _mm256_i32gather_ps(coeff.two_pt_offset_x,line_id,4)));
+        __m256 corr_y = _mm256_and_ps(two_pt,_mm256_fmadd_ps(yy,_mm256_i32gather_ps(coeff.two_pt_slope_y,line_id,4),
+                                                             _mm256_i32gather_ps(coeff.two_pt_offset_y,line_id,4)));
+        __m256 cos_vert = _mm256_i32gather_ps(coeff.cos_vert_correction,line_id,4);
+        xy_distance_x = _mm256_fmadd_ps(corr_x,cos_vert,xy_distance);
+        xy_distance_y = _mm256_fmadd_ps(corr_y,cos_vert,xy_distance);
+        z = _mm256_fmadd_ps(corr_y,_mm256_i32gather_ps(coeff.sin_vert_correction,line_id,4),z);
+    }
+    __m256 x = _mm256_fmsub_ps(xy_distance_x,sin_rot_angle,horiz_cos);
+    __m256 y = _mm256_fmadd_ps(xy_distance_y,cos_rot_angle,horiz_sin);
+    if(extrinsic != nullptr)
+    {
+        transformLane8(extrinsic,x,y,z);
+    }
+    if(coeff.region_available || coeff.body_available)
+    {
+        keep = filterRegionLane8(coeff,count,x,y,z,keep);
+        if(keep == 0)
+        {
+            return;
+        }
+    }
+
+    __m256 range_term = _mm256_fnmadd_ps(raw_distance,_mm256_set1_ps((float)(1.0 / 65535)),_mm256_set1_ps(1.0f));
+    __m256 range_offset = _mm256_mul_ps(_mm256_mul_ps(_mm256_set1_ps(256),range_term),range_term);
+    __m256 focal_gap = _mm256_andnot_ps(_mm256_set1_ps(-0.0f),_mm256_sub_ps(lane.focal_offset,range_offset));
+    __m256i intensity = _mm256_cvttps_epi32(_mm256_fmadd_ps(lane.focal_slope,focal_gap,raw_intensity));
+    intensity = _mm256_max_epi32(intensity,_mm256_cvttps_epi32(lane.min_intensity));
+    __m256i max_intensity = _mm256_cvttps_epi32(lane.max_intensity);
+    intensity = _mm256_blendv_epi8(intensity,max_intensity,_mm256_cmpgt_epi32(_mm256_cvttps_epi32(raw_intensity),max_intensity));
+
+    __m256i order = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *)compress_table8.order[keep]));
+    unsigned int n = cloud.point_num;
+    _mm256_storeu_ps(cloud.x + n,_mm256_permutevar8x32_ps(x,order));
+    _mm256_storeu_ps(cloud.y + n,_mm256_permutevar8x32_ps(y,order));
+    _mm256_storeu_ps(cloud.z + n,_mm256_permutevar8x32_ps(z,order));
+    int intensity_lane[8];
+    int line_lane[8];
+    _mm256_storeu_si256((__m256i *)intensity_lane,intensity);
+    _mm256_storeu_si256((__m256i *)line_lane,line_id);
+    while(keep)
+    {
+        int k = __builtin_ctz(keep);
+        cloud.intensity[n] = (unsigned char)intensity_lane[k];
+        cloud.line_id[n] = (unsigned char)line_lane[k];
+        n ++;
+        keep &= keep - 1;
+    }
+    cloud.point_num = n;
+}
+
+__attribute__((target("avx2,fma")))
+static void convBlockAVX2(const LaserCoeffT<float> & coeff, const float * cos_rot_table, const float * sin_rot_table,
+                          const TrigTable & trig, const unsigned short * distance, const unsigned char * intensity,
+                          int line_base, unsigned short rot_angle, const float * extrinsic, unsigned int keep,
+                          FilterCount & count, CloudXYZIf & cloud)
+{
+    __m256 cos_rot = _mm256_set1_ps(cos_rot_table[rot_angle]);
+    __m256 sin_rot = _mm256_set1_ps(sin_rot_table[rot_angle]);
+    int trig_index = trig.format == TRIG_TABLE_OFF ? 0 : trigColumn(trig,rot_angle) * 2 * LASER_NUM + line_base;
+    LaserLane8 lane;
+    __m256 cos_rot_angle;
+    __m256 sin_rot_angle;
+    for(int k = 0; k < 32; k += 8)
+    {
+        int keep8 = (keep >> k) & 255;
+        if(keep8 == 0)
+        {
+            continue;
+        }
+        __m256 raw_distance = _mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i *)(distance + k))));
+        __m256 raw_intensity = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *)(intensity + k))));
+        __m256i line_id = _mm256_add_epi32(_mm256_set1_epi32(line_base + k),_mm256_setr_epi32(0,1,2,3,4,5,6,7));
+        loadLaserLane8(coeff,line_base + k,lane);
+        if(trig.format == TRIG_TABLE_OFF)
+        {
+            rotLane8(lane,cos_rot,sin_rot,cos_rot_angle,sin_rot_angle);
+        }
+        else
+        {
+            loadTrigLane8(trig,trig_index + k,cos_rot_angle,sin_rot_angle);
+        }
+        convLane8(coeff,lane,raw_distance,raw_intensity,line_id,cos_rot_angle,sin_rot_angle,extrinsic,keep8,count,cloud);
+    }
+}
+
+__attribute__((target("avx2,fma")))
+static int convPointsAVX2(const LaserCoeffT<float> & coeff, const float * cos_rot_table, const float * sin_rot_table,
+                          const TrigTable & trig, const unsigned char * line_id, const unsigned short * rot_angle,
+                          const unsigned short * distance, const unsigned char * intensity,
+                          int num, const CalibFilter * filter, FilterCount & count, CloudXYZIf & cloud)
+{
+    LaserLane8 lane;
+    __m256 cos_rot_angle;
+    __m256 sin_rot_angle;
+    int trig_index[8];
+    int i = 0;
+    for(; i + 8 <= num && cloud.point_num + 8 <= cloud.max_point_num; i += 8)
+    {
+        int keep = 255;
+        if(filter != nullptr)
+        {
+            keep = 0;
+            for(int k = 0; k < 8; k++)
+            {
+                keep |= (int)filterPoint(*filter,count,line_id[i + k],rot_angle[i + k],distance[i + k]) << k;
+            }
+            if(keep == 0)
+            {
+                continue;
+            }
+        }
+        __m256 raw_distance = _mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i *)(distance + i))));
+        __m256 raw_intensity = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *)(intensity + i))));
+        __m256i line8 = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *)(line_id + i)));
+        __m256i rot8 = _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i *)(rot_angle + i)));
+        gatherLaserLane8(coeff,line8,lane);
+        if(trig.format == TRIG_TABLE_OFF)
+        {
+            rotLane8(lane,_mm256_i32gather_ps(cos_rot_table,rot8,4),_mm256_i32gather_ps(sin_rot_table,rot8,4),
+                     cos_rot_angle,sin_rot_angle);
+        }
+        else
+        {
+            for(int k = 0; k < 8; k++)
+            {
+                trig_index[k] = trigColumn(trig,rot_angle[i + k]) * 2 * LASER_NUM + line_id[i + k];
+            }
+            gatherTrigLane8(trig,_mm256_loadu_si256((const __m256i *)trig_index),cos_rot_angle,sin_rot_angle);
+        }
+        convLane8(coeff,lane,raw_distance,raw_intensity,line8,cos_rot_angle,sin_rot_angle,
+                  coeff.extrinsic_available ? coeff.extrinsic : nullptr,keep,count,cloud);
+    }
+    return i;
+}
+
+//a (at most 2^22) times b in Q15, the product split so that it stays in 32 bits
+static inline int mulQ15(int a, int b)
+{
+    return ((a >> 7) * b + (((a & 127) * b) >> 7) + 128) >> 8;
+}
+
+//raw distance (16 bits) times a Q16 scale plus a Q8 offset, the distance split for 32 bits
+static inline int mulDistance(int raw_distance, int scale, int offset)
+{
+    return ((raw_distance >> 8) * scale + (((raw_distance & 255) * scale) >> 8) + offset) >> 8;
+}
+
+/** @brief fixed point convLRDI2XYZI, the lanes of the AVX2 kernel do the same
+ *  @param coefficients of the unit, line, Q15 azimuth cos and sin, raw distance and intensity
+ */
+static inline void convPointInt(const LaserCoeffInt & coeff, int line, int cos_az, int sin_az, int raw_distance,
+                                int raw_intensity, Point3II & output_Point3II)
+{
+    int cos_rot_angle = (cos_az * coeff.cos_rot_correction[line] + sin_az * coeff.sin_rot_correction[line] + 16384) >> 15;
+    int sin_rot_angle = (sin_az * coeff.cos_rot_correction[line] - cos_az * coeff.sin_rot_correction[line] + 16384) >> 15;
+    int xy_distance = mulDistance(raw_distance,coeff.xy_scale[line],coeff.xy_offset[line]);
+    int z = mulDistance(raw_distance,coeff.z_scale[line],coeff.z_offset[line]);
+    int horiz_cos = (coeff.horiz_offset_correction[line] * cos_rot_angle + 16384) >> 15;
+    int horiz_sin = (coeff.horiz_offset_correction[line] * sin_rot_angle + 16384) >> 15;
+    int x = mulQ15(xy_distance,sin_rot_angle) - horiz_cos;
+    int y = mulQ15(xy_distance,cos_rot_angle) + horiz_sin;
+    if(coeff.extrinsic_available)
+    {
+        const int * e = coeff.extrinsic;
+        int x0 = x;
+        int y0 = y;
+        x = mulQ15(x0,e[0]) + mulQ15(y0,e[1]) + mulQ15(z,e[2]) + e[3];
+        y = mulQ15(x0,e[4]) + mulQ15(y0,e[5]) + mulQ15(z,e[6]) + e[7];
+        z = mulQ15(x0,e[8]) + mulQ15(y0,e[9]) + mulQ15(z,e[10]) + e[11];
+    }
+    output_Point3II.x = (x + 8) >> 4;
+    output_Point3II.y = (y + 8) >> 4;
+    output_Point3II.z = (z + 8) >> 4;
+
+    //256 * (1 - r / 65535)^2 in Q10
+    //(65535 - r)^2 / 16384 is short of it by 1 / 32768
+    unsigned int range_term = 65535 - raw_distance;
+    int range_offset = (int)((range_term * range_term) >> 14);
+    range_offset += range_offset >> 15;
+    int focal_gap = abs(coeff.focal_offset[line] - range_offset);
+    int intensity = raw_intensity + ((((focal_gap >> 8) * coeff.focal_slope[line]) + (((focal_gap & 255) * coeff.focal_slope[line]) >> 8)) >> 16);
+    if(intensity < coeff.min_intensity[line])
+    {
+        intensity = coeff.min_intensity[line];
+    }
+    if(raw_intensity > coeff.max_intensity[line])
+    {
+        intensity = coeff.max_intensity[line];
+    }
+    output_Point3II.intensity = intensity;
+}
+
+__attribute__((target("avx2")))
+static inline __m256i mulQ15AVX2(__m256i a, __m256i b)
+{
+    __m256i high = _mm256_mullo_epi32(_mm256_srai_epi32(a,7),b);
+    __m256i low = _mm256_srai_epi32(_mm256_mullo_epi32(_mm256_and_si256(a,_mm256_set1_epi32(127)),b),7);
+    return _mm256_srai_epi32(_mm256_add_epi32(_mm256_add_epi32(high,low),_mm256_set1_epi32(128)),8);
+}
+
+__attribute__((target("avx2")))
+static inline __m256i mulDistanceAVX2(__m256i raw_distance, __m256i scale, __m256i offset)
+{
+    __m256i high = _mm256_mullo_epi32(_mm256_srli_epi32(raw_distance,8),scale);
+    __m256i low = _mm256_srai_epi32(_mm256_mullo_epi32(_mm256_and_si256(raw_distance,_mm256_set1_epi32(255)),scale),8);
+    return _mm256_srai_epi32(_mm256_add_epi32(_mm256_add_epi32(high,low),offset),8);
+}
+
+//insideBoxLane8 on integer points
+__attribute__((target("avx2")))
+static inline int insideBoxInt8(const int * box, __m256i x, __m256i y, __m256i z)
+{
+    __m256i outside = _mm256_or_si256(_mm256_cmpgt_epi32(_mm256_set1_epi32(box[0]),x),_mm256_cmpgt_epi32(x,_mm256_set1_epi32(box[1])));
+    outside = _mm256_or_si256(outside,_mm256_or_si256(_mm256_cmpgt_epi32(_mm256_set1_epi32(box[2]),y),_mm256_cmpgt_epi32(y,_mm256_set1_epi32(box[3]))));
+    outside = _mm256_or_si256(outside,_mm256_or_si256(_mm256_cmpgt_epi32(_mm256_set1_epi32(box[4]),z),_mm256_cmpgt_epi32(z,_mm256_set1_epi32(box[5]))));
+    return ~_mm256_movemask_ps(_mm256_castsi256_ps(outside)) & 255;
+}
+
+//32 lasers of one block into the lines of the cloud, 8 lanes of convPointInt per step, bit k of keep for laser k
+__attribute__((target("avx2")))
+static int convBlockIntAVX2(const LaserCoeffInt & coeff, int cos_az, int sin_az,
+                            const unsigned short * distance, const unsigned char * intensity,
+                            int line_base, unsigned int keep_block, FilterCount & count, PointCloud & cloud)
+{
+    const __m256i round15 = _mm256_set1_epi32(16384);
+    const __m256i round4 = _mm256_set1_epi32(8);
+    __m256i cos_az8 = _mm256_set1_epi32(cos_az);
+    __m256i sin_az8 = _mm256_set1_epi32(sin_az);
+    int point_num = 0;
+    for(int k = 0; k < 32; k += 8)
+    {
+        __m256i raw_distance = _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i *)(distance + k)));
+        int keep = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(raw_distance,_mm256_setzero_si256())));
+        keep &= (keep_block >> k) & 255;
+        if(keep == 0)
+        {
+            continue;
+        }
+        int line = line_base + k;
+        __m256i raw_intensity = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *)(intensity + k)));
+        __m256i cos_corr = _mm256_load_si256((const __m256i *)(coeff.cos_rot_correction + line));
+        __m256i sin_corr = _mm256_load_si256((const __m256i *)(coeff.sin_rot_correction + line));
+        __m256i horiz = _mm256_load_si256((const __m256i *)(coeff.horiz_offset_correction + line));
+        __m256i cos_rot_angle = _mm256_srai_epi32(_mm256_add_epi32(_mm256_add_epi32(_mm256_mullo_epi32(cos_az8,cos_corr),
+                                                                                    _mm256_mullo_epi32(sin_az8,sin_corr)),round15),15);
+        __m256i sin_rot_angle = _mm256_srai_epi32(_mm256_add_epi32(_mm256_sub_epi32(_mm256_mullo_epi32(sin_az8,cos_corr),
+                                                                                    _mm256_mullo_epi32(cos_az8,sin_corr)),round15),15);
+        __m256i xy_distance = mulDistanceAVX2(raw_distance,_mm256_load_si256((const __m256i *)(coeff.xy_scale + line)),
+                                              _mm256_load_si256((const __m256i *)(coeff.xy_offset + line)));
+        __m256i z = mulDistanceAVX2(raw_distance,_mm256_load_si256((const __m256i *)(coeff.z_scale + line)),
+                                    _mm256_load_si256((const __m256i *)(coeff.z_offset + line)));
+        __m256i horiz_cos = _mm256_srai_epi32(_mm256_add_epi32(_mm256_mullo_epi32(horiz,cos_rot_angle),round15),15);
+        __m256i horiz_sin = _mm256_srai_epi32(_mm256_add_epi32(_mm256_mullo_epi32(horiz,sin_rot_angle),round15),15);
+        __m256i x = _mm256_sub_epi32(mulQ15AVX2(xy_distance,sin_rot_angle),horiz_cos);
+        __m256i y = _mm256_add_epi32(mulQ15AVX2(xy_distance,cos_rot_angle),horiz_sin);
+        if(coeff.extrinsic_available)
+        {
+            const int * e = coeff.extrinsic;
+            __m256i x0 = x;
+            __m256i y0 = y;
+            __m256i z0 = z;
+            x = _mm256_add_epi32(_mm256_add_epi32(mulQ15AVX2(x0,_mm256_set1_epi32(e[0])),mulQ15AVX2(y0,_mm256_set1_epi32(e[1]))),
+                                 _mm256_add_epi32(mulQ15AVX2(z0,_mm256_set1_epi32(e[2])),_mm256_set1_epi32(e[3])));
+            y = _mm256_add_epi32(_mm256_add_epi32(mulQ15AVX2(x0,_mm256_set1_epi32(e[4])),mulQ15AVX2(y0,_mm256_set1_epi32(e[5]))),
+                                 _mm256_add_epi32(mulQ15AVX2(z0,_mm256_set1_epi32(e[6])),_mm256_set1_epi32(e[7])));
+            z = _mm256_add_epi32(_mm256_add_epi32(mulQ15AVX2(x0,_mm256_set1_epi32(e[8])),mulQ15AVX2(y0,_mm256_set1_epi32(e[9]))),
+                                 _mm256_add_epi32(mulQ15AVX2(z0,_mm256_set1_epi32(e[10])),_mm256_set1_epi32(e[11])));
+        }
+        x = _mm256_srai_epi32(_mm256_add_epi32(x,round4),4);
+        y = _mm256_srai_epi32(_mm256_add_epi32(y,round4),4);
+        z = _mm256_srai_epi32(_mm256_add_epi32(z,round4),4);
+        if(coeff.region_available)
+        {
+            int inside = insideBoxInt8(coeff.region,x,y,z);
+            count.rejected[FILTER_REGION] += __builtin_popcount(keep & ~inside);
+            keep &= inside;
+        }
+        if(coeff.body_available)
+        {
+            int inside = insideBoxInt8(coeff.body,x,y,z);
+            count.rejected[FILTER_BODY] += __builtin_popcount(keep & inside);
+            keep &= ~inside;
+        }
+        if(keep == 0)
+        {
+            continue;
+        }
+
+        __m256i range_term = _mm256_sub_epi32(_mm256_set1_epi32(65535),raw_distance);
+        __m256i range_offset = _mm256_srli_epi32(_mm256_mullo_epi32(range_term,range_term),14);
+        range_offset = _mm256_add_epi32(range_offset,_mm256_srli_epi32(range_offset,15));
+        __m256i focal_gap = _mm256_abs_epi32(_mm256_sub_epi32(_mm256_load_si256((const __m256i *)(coeff.focal_offset + line)),range_offset));
+        __m256i focal_slope = _mm256_load_si256((const __m256i *)(coeff.focal_slope + line));
+        __m256i focal_high = _mm256_mullo_epi32(_mm256_srli_epi32(focal_gap,8),focal_slope);
+        __m256i focal_low = _mm256_srai_epi32(_mm256_mullo_epi32(_mm256_and_si256(focal_gap,_mm256_set1_epi32(255)),focal_slope),8);
+        __m256i inten = _mm256_add_epi32(raw_intensity,_mm256_srai_epi32(_mm256_add_epi32(focal_high,focal_low),16));
+        inten = _mm256_max_epi32(inten,_mm256_load_si256((const __m256i *)(coeff.min_intensity + line)));
+        __m256i max_intensity = _mm256_load_si256((const __m256i *)(coeff.max_intensity + line));
+        inten = _mm256_blendv_epi8(inten,max_intensity,_mm256_cmpgt_epi32(raw_intensity,max_intensity));
+
+        //every laser has its own line, so the points are scattered one by one
+        int x_lane[8];
+        int y_lane[8];
+        int z_lane[8];
+        int intensity_lane[8];
+        _mm256_storeu_si256((__m256i *)x_lane,x);
+        _mm256_storeu_si256((__m256i *)y_lane,y);
+        _mm256_storeu_si256((__m256i *)z_lane,z);
+        _mm256_storeu_si256((__m256i *)intensity_lane,inten);
+        while(keep)
+        {
+            int lane = __builtin_ctz(keep);
+            keep &= keep - 1;
+            int & n = cloud.line_point_num[line + lane];
+            if(n >= cloud.max_line_point)
+            {
+                continue;
+            }
+            Point3II & point = cloud.line_point_cloud[line + lane][n ++];
+            point.x = x_lane[lane];
+            point.y = y_lane[lane];
+            point.z = z_lane[lane];
+            point.intensity = intensity_lane[lane];
+            point_num ++;
+        }
+    }
+    return point_num;
+}
+
+template <typename Real>
+void VeloCalibT<Real>::convBlock(const unsigned short *distance, const unsigned char *intensity, unsigned short upper_or_lower,
+                                 unsigned short rot_angle, const Real *extrinsic, Cloud &cloud, FilterCount &count)
+{
+    int line_base = upper_or_lower == LOWER_BLOCK ? 32 : 0;
+    unsigned int keep = filter_raw ? filterBlock(filter,count,distance,line_base,rot_angle) : 0xFFFFFFFF;
+    if(keep == 0)
+    {
+        return;
+    }
+    if(conv_level == CALIB_AVX2)
+    {
+        convBlockAVX2(*laser_coeff,cos_rot_table,sin_rot_table,trig_table,distance,intensity,line_base,rot_angle,
+                      extrinsic,keep,count,cloud);
+        return;
+    }
+    PointLRDI point;
+    Point out;
+    point.rot_angle = rot_angle;
+    for(int k = 0; k < 32; k++)
+    {
+        if(((keep >> k) & 1) == 0)
+        {
+            continue;
+        }
+        point.line_id = line_base + k;
+        point.distance = distance[k];
+        point.intensity = intensity[k];
+        if(convPoint(&point,out,extrinsic) && filterRegion(*laser_coeff,count,out.x,out.y,out.z))
+        {
+            unsigned int n = cloud.point_num ++;
+            cloud.x[n] = out.x;
+            cloud.y[n] = out.y;
+            cloud.z[n] = out.z;
+            cloud.intensity[n] = out.intensity;
+            cloud.line_id[n] = point.line_id;
+        }
+    }
+}
+
+/** @brief converse the blocks [begin,end) of a FrameData block array or of a CompactFrame,
+ *  appended to the cloud while 32 more points fit
+ *  @param blocks of a FrameData, nullptr to take the compact frame
+ *  @param compact frame
+ *  @param first block and the end
+ *  @param cloud and the rejection counters
+ */
+template <typename Real>
+void VeloCalibT<Real>::convRange(const Block *block_data, const CompactFrame *compact, unsigned int begin,
+                                 unsigned int end, Cloud &cloud, FilterCount &count)
+{
+    Real extrinsic_buf[12];
+    unsigned int buf_time = ~0U;
+    if(block_data == nullptr)
+    {
+        for(unsigned int i = begin; i < end && cloud.point_num + 32 <= cloud.max_point_num; i++)
+        {
+            convBlock(compact->distance[i],compact->intensity[i],compact->upper_or_lower[i],compact->rot_angle[i],
+                      blockExtrinsic(compact->gps_time_stampe[i],extrinsic_buf,buf_time),cloud,count);
+        }
+        return;
+    }
+    unsigned short distance[32];
+    unsigned char intensity[32];
+    for(unsigned int i = begin; i < end && cloud.point_num + 32 <= cloud.max_point_num; i++)
+    {
+        const Block & block = block_data[i];
+        for(int k = 0; k < 32; k++)
+        {
+            distance[k] = (unsigned short)block.fire_laser[k].distance;
+            intensity[k] = block.fire_laser[k].intensity;
+        }
+        convBlock(distance,intensity,block.upper_or_lower,block.rot_angle,
+                  blockExtrinsic(block.gps_time_stampe,extrinsic_buf,buf_time),cloud,count);
+    }
+}
+
+template <typename Real>
+int VeloCalibT<Real>::convFrame(const FrameData *frame, Cloud &cloud)
+{
+    cloud.point_num = 0;
+    return convBlocks(frame->frame_block,frame->block_num,cloud);
+}
+
+template <typename Real>
+int VeloCalibT<Real>::convBlocks(const Block *block_data, unsigned int block_num, Cloud &cloud)
+{
+    convRange(block_data,nullptr,0,block_num,cloud,filter_count);
+    return cloud.point_num;
+}
+
+template <typename Real>
+int VeloCalibT<Real>::convFrame(const CompactFrame *compact, Cloud &cloud)
+{
+    cloud.point_num = 0;
+    convRange(nullptr,compact,0,compact->block_num,cloud,filter_count);
+    return cloud.point_num;
+}
+
+template <typename Real>
+int VeloCalibT<Real>::convFrame(const FrameData *frame, Cloud &cloud, ThreadPool &pool, int chunk_block_num)
+{
+    return convFramePool(frame->frame_block,nullptr,frame->block_num,cloud,pool,chunk_block_num);
+}
+
+template <typename Real>
+int VeloCalibT<Real>::convFrame(const CompactFrame *compact, Cloud &cloud, ThreadPool &pool, int chunk_block_num)
+{
+    return convFramePool(nullptr,compact,compact->block_num,cloud,pool,chunk_block_num);
+}
+
+//points written ahead of a chunk in the cloud before its direct part, more than the
+//lanes a vector store may write past the last point
+#define CHUNK_HEAD_POINT 8
+#define CHUNK_HEAD_CAPACITY 64
+
+/** @brief the frame conversions on a thread pool. without the region and body rules the points
+ *  kept by a chunk are known from the raw data: they are counted first, then every chunk is
+ *  converted straight to its place in the cloud. the first CHUNK_HEAD_POINT points of a chunk go
+ *  through chunk_head and are copied once all chunks are done, as the vector stores of the chunk
+ *  before may write a few lanes past its end. otherwise every chunk is converted into its own
+ *  part of chunk_cloud and the chunks are packed one after the other
+ *  @return number of points in the cloud
+ */
+template <typename Real>
+int VeloCalibT<Real>::convFramePool(const Block *block_data, const CompactFrame *compact, unsigned int block_num,
+                                    Cloud &cloud, ThreadPool &pool, int chunk_block_num)
+{
+    if(chunk_block_num < 1)
+    {
+        chunk_block_num = 1;
+    }
+    unsigned int chunk_num = (block_num + chunk_block_num - 1) / chunk_block_num;
+    if(chunk_num > chunk_capacity)
+    {
+        delete [] chunk_point_num;
+        delete [] chunk_head_num;
+        delete [] chunk_offset;
+        delete [] chunk_count;
+        freeCloud(chunk_head);
+        chunk_capacity = chunk_num;
+        chunk_point_num = new unsigned int[chunk_capacity];
+        chunk_head_num = new unsigned int[chunk_capacity];
+        chunk_offset = new unsigned int[chunk_capacity];
+        chunk_count = new FilterCount[chunk_capacity];
+        chunk_head = createCloud<Real>(chunk_capacity * CHUNK_HEAD_CAPACITY);
+    }
+    job_block = block_data;
+    job_compact = compact;
+    job_block_num = block_num;
+    job_chunk_block_num = chunk_block_num;
+    job_cloud = &cloud;
+    job_direct = false;
+
+    //stp1. points of every chunk and where they go
+    unsigned int point_num = 0;
+    if(!laser_coeff->region_available && !laser_coeff->body_available)
+    {
+        pool.run(chunk_num,countChunkTask,this);
+        for(unsigned int i = 0; i < chunk_num; i++)
+        {
+            chunk_offset[i] = point_num;
+            point_num += chunk_point_num[i];
+        }
+        //the stores of a block stay in the 32 points after the ones before it, so 32 points per
+        //block are room enough as well
+        job_direct = point_num + CHUNK_HEAD_POINT <= cloud.max_point_num || block_num * 32 <= cloud.max_point_num;
+    }
+    if(!job_direct && (chunk_cloud == nullptr || chunk_cloud->max_point_num < block_num * 32))
+    {
+        freeCloud(chunk_cloud);
+        chunk_cloud = createCloud<Real>(block_num * 32);
+    }
+
+    //stp2. converse the chunks
+    pool.run(chunk_num,convChunkTask,this);
+    for(unsigned int i = 0; i < chunk_num; i++)
+    {
+        for(int r = 0; r < FILTER_RULE_NUM; r++)
+        {
+            filter_count.rejected[r] += chunk_count[i].rejected[r];
+        }
+    }
+
+    //stp3. the heads of the chunks, or the whole chunks, into the cloud
+    if(job_direct)
+    {
+        for(unsigned int i = 0; i < chunk_num; i++)
+        {
+            size_t head = (size_t)i * CHUNK_HEAD_CAPACITY;
+            unsigned int n = chunk_head_num[i];
+            memcpy(cloud.x + chunk_offset[i],chunk_head->x + head,n * sizeof(Real));
+            memcpy(cloud.y + chunk_offset[i],chunk_head->y + head,n * sizeof(Real));
+            memcpy(cloud.z + chunk_offset[i],chunk_head->z + head,n * sizeof(Real));
+            memcpy(cloud.intensity + chunk_offset[i],chunk_head->intensity + head,n);
+            memcpy(cloud.line_id + chunk_offset[i],chunk_head->line_id + head,n);
+        }
+        cloud.point_num = point_num;
+        return cloud.point_num;
+    }
+    point_num = 0;
+    for(unsigned int i = 0; i < chunk_num; i++)
+    {
+        chunk_offset[i] = point_num;
+        point_num += chunk_point_num[i];
+    }
+    pool.run(chunk_num,packChunkTask,this);
+    cloud.point_num = point_num < cloud.max_point_num ? point_num : cloud.max_point_num;
+    return cloud.point_num;
+}
+
+//bit k set when distance k of the block is not 0, 16 distances per sse2 compare
+static inline unsigned int distanceMask(const unsigned short * distance)
+{
+    unsigned int zero = 0;
+    for(int k = 0; k < 32; k += 16)
+    {
+        __m128i lo = _mm_cmpeq_epi16(_mm_loadu_si128((const __m128i *)(distance + k)),_mm_setzero_si128());
+        __m128i hi = _mm_cmpeq_epi16(_mm_loadu_si128((const __m128i *)(distance + k + 8)),_mm_setzero_si128());
+        zero |= (unsigned int)_mm_movemask_epi8(_mm_packs_epi16(lo,hi)) << k;
+    }
+    return ~zero;
+}
+
+//blocks [begin,end) of the chunk
+template <typename Real>
+static void chunkRange(int task, int chunk_block_num, unsigned int block_num, unsigned int & begin, unsigned int & end)
+{
+    begin = (unsigned int)task * chunk_block_num;
+    end = begin + chunk_block_num;
+    if(end > block_num)
+    {
+        end = block_num;
+    }
+}
+
+template <typename Real>
+void VeloCalibT<Real>::countChunkTask(void *arg, int task, int worker)
+{
+    (void)worker;
+    VeloCalibT<Real> * calib = (VeloCalibT<Real> *)arg;
+    unsigned int begin;
+    unsigned int end;
+    chunkRange<Real>(task,calib->job_chunk_block_num,calib->job_block_num,begin,end);
+    //the points convBlock keeps: a distance and every raw rule of the filter passed
+    FilterCount count;
+    unsigned short distance_buf[32];
+    unsigned int point_num = 0;
+    for(unsigned int i = begin; i < end; i++)
+    {
+        const unsigned short * distance;
+        unsigned short upper_or_lower;
+        unsigned short rot_angle;
+        if(calib->job_block == nullptr)
+        {
+            distance = calib->job_compact->distance[i];
+            upper_or_lower = calib->job_compact->upper_or_lower[i];
+            rot_angle = calib->job_compact->rot_angle[i];
+        }
+        else
+        {
+            const Block & block = calib->job_block[i];
+            for(int k = 0; k < 32; k++)
+            {
+                distance_buf[k] = (unsigned short)block.fire_laser[k].distance;
+            }
+            distance = distance_buf;
+            upper_or_lower = block.upper_or_lower;
+            rot_angle = block.rot_angle;
+        }
+        unsigned int keep = distanceMask(distance);
+        if(calib->filter_raw)
+        {
+            keep &= filterBlock(calib->filter,count,distance,upper_or_lower == LOWER_BLOCK ? 32 : 0,rot_angle);
+        }
+        point_num += __builtin_popcount(keep);
+    }
+    calib->chunk_point_num[task] = point_num;
+}
+
+template <typename Real>
+void VeloCalibT<Real>::convChunkTask(void *arg, int task, int worker)
+{
+    (void)worker;
+    VeloCalibT<Real> * calib = (VeloCalibT<Real> *)arg;
+    unsigned int begin;
+    unsigned int end;
+    chunkRange<Real>(task,calib->job_chunk_block_num,calib->job_block_num,begin,end);
+    FilterCount & count = calib->chunk_count[task];
+    count = FilterCount();
+    if(!calib->job_direct)
+    {
+        //the part of chunk_cloud of this chunk, 32 points per block
+        Cloud view = *calib->chunk_cloud;
+        size_t base = (size_t)begin * 32;
+        view.point_num = 0;
+        view.max_point_num = (end - begin) * 32;
+        view.x += base;
+        view.y += base;
+        view.z += base;
+        view.intensity += base;
+        view.line_id += base;
+        calib->convRange(calib->job_block,calib->job_compact,begin,end,view,count);
+        calib->chunk_point_num[task] = view.point_num;
+        return;
+    }
+    //the head in chunk_head, block by block until it holds CHUNK_HEAD_POINT points
+    Cloud head = *calib->chunk_head;
+    size_t base = (size_t)task * CHUNK_HEAD_CAPACITY;
+    head.point_num = 0;
+    head.max_point_num = CHUNK_HEAD_CAPACITY;
+    head.x += base;
+    head.y += base;
+    head.z += base;
+    head.intensity += base;
+    head.line_id += base;
+    unsigned int i = begin;
+    for(; i < end && head.point_num < CHUNK_HEAD_POINT; i++)
+    {
+        calib->convRange(calib->job_block,calib->job_compact,i,i + 1,head,count);
+    }
+    calib->chunk_head_num[task] = head.point_num;
+    //the rest straight into the cloud behind the head
+    Cloud view = *calib->job_cloud;
+    size_t offset = calib->chunk_offset[task];
+    view.point_num = head.point_num;
+    view.max_point_num = calib->chunk_point_num[task] + 32;
+    view.x += offset;
+    view.y += offset;
+    view.z += offset;
+    view.intensity += offset;
+    view.line_id += offset;
+    calib->convRange(calib->job_block,calib->job_compact,i,end,view,count);
+}
+
+template <typename Real>
+void VeloCalibT<Real>::packChunkTask(void *arg, int task, int worker)
+{
+    (void)worker;
+    VeloCalibT<Real> * calib = (VeloCalibT<Real> *)arg;
+    Cloud & cloud = *calib->job_cloud;
+    unsigned int offset = calib->chunk_offset[task];
+    if(offset >= cloud.max_point_num)
+    {
+        return;
+    }
+    unsigned int n = calib->chunk_point_num[task];
+    if(n > cloud.max_point_num - offset)
+    {
+        n = cloud.max_point_num - offset;
+    }
+    size_t src = (size_t)task * calib->job_chunk_block_num * 32;
+    const Cloud & chunk = *calib->chunk_cloud;
+    memcpy(cloud.x + offset,chunk.x + src,n * sizeof(Real));
+    memcpy(cloud.y + offset,chunk.y + src,n * sizeof(Real));
+    memcpy(cloud.z + offset,chunk.z + src,n * sizeof(Real));
+    memcpy(cloud.intensity + offset,chunk.intensity + src,n);
+    memcpy(cloud.line_id + offset,chunk.line_id + src,n);
+}
+
+template <typename Real>
+int VeloCalibT<Real>::convFrame(const FrameData *frame, Image &image)
+{
+    convImage(frame->frame_block,nullptr,frame->block_num,image);
+    return image.point_num;
+}
+
+template <typename Real>
+int VeloCalibT<Real>::convFrame(const CompactFrame *compact, Image &image)
+{
+    convImage(nullptr,compact,compact->block_num,image);
+    return image.point_num;
+}
+
+/** @brief the range image of a frame. every block goes through convBlock() into a cloud of
+ *  one block on the stack, its points are then put into the cells of their rows in the
+ *  column of the block
+ *  @param blocks of a FrameData, nullptr to take the compact frame
+ *  @param compact frame
+ *  @param number of blocks
+ *  @param range image, cleared first
+ */
+template <typename Real>
+void VeloCalibT<Real>::convImage(const Block *block_data, const CompactFrame *compact, unsigned int block_num, Image &image)
+{
+    //stp1. rows of the lasers, scan_table is sorted from the bottom
+    unsigned char laser_row[LASER_NUM];
+    for(int r = 0; r < LASER_NUM; r++)
+    {
+        image.row_line[r] = (unsigned char)scan_table[r].x;
+        laser_row[image.row_line[r]] = r;
+    }
+    memset(image.range,0,(size_t)image.row_num * image.column_num * sizeof(Real));
+    image.point_num = 0;
+
+    //stp2. one block at a time, 32 points and the lanes a vector store may write past them
+    Real x[40];
+    Real y[40];
+    Real z[40];
+    unsigned char point_intensity[40];
+    unsigned char line_id[40];
+    Cloud block_cloud;
+    block_cloud.max_point_num = 40;
+    block_cloud.x = x;
+    block_cloud.y = y;
+    block_cloud.z = z;
+    block_cloud.intensity = point_intensity;
+    block_cloud.line_id = line_id;
+    unsigned short distance_buf[32];
+    unsigned char intensity_buf[32];
+    Real extrinsic_buf[12];
+    unsigned int buf_time = ~0U;
+    for(unsigned int i = 0; i < block_num; i++)
+    {
+        const unsigned short * distance;
+        const unsigned char * intensity;
+        unsigned short upper_or_lower;
+        unsigned short rot_angle;
+        unsigned int time_stampe;
+        if(block_data == nullptr)
+        {
+            distance = compact->distance[i];
+            intensity = compact->intensity[i];
+            upper_or_lower = compact->upper_or_lower[i];
+            rot_angle = compact->rot_angle[i];
+            time_stampe = compact->gps_time_stampe[i];
+        }
+        else
+        {
+            const Block & block = block_data[i];
+            for(int k = 0; k < 32; k++)
+            {
+                distance_buf[k] = (unsigned short)block.fire_laser[k].distance;
+                intensity_buf[k] = block.fire_laser[k].intensity;
+            }
+            distance = distance_buf;
+            intensity = intensity_buf;
+            upper_or_lower = block.upper_or_lower;
+            rot_angle = block.rot_angle;
+            time_stampe = block.gps_time_stampe;
+        }
+        block_cloud.point_num = 0;
+        convBlock(distance,intensity,upper_or_lower,rot_angle,blockExtrinsic(time_stampe,extrinsic_buf,buf_time),
+                  block_cloud,filter_count);
+
+        //stp3. the points into the column of the block
+        int line_base = upper_or_lower == LOWER_BLOCK ? 32 : 0;
+        size_t column = (size_t)((rot_angle % 36000) / image.azimuth_step) * image.row_num;
+        for(unsigned int j = 0; j < block_cloud.point_num; j++)
+        {
+            int line = line_id[j];
+            size_t cell = column + laser_row[line];
+            image.point_num += image.range[cell] == 0 ? 1 : 0;
+            image.range[cell] = (Real)(distance[line - line_base] * DISTANCE_RESOLUTION + in_param[line].dist_correction);
+            image.x[cell] = x[j];
+            image.y[cell] = y[j];
+            image.z[cell] = z[j];
+            image.intensity[cell] = point_intensity[j];
+        }
+    }
+}
+
+template <typename Real>
+int VeloCalibT<Real>::convLRDI2XYZII(PointLRDI_ptr input_PointLRDI, Point3II &output_Point3II, int unit)
+{
+    if(input_PointLRDI->distance == 0)
+    {
+        return 0;
+    }
+    int line = input_PointLRDI->line_id;
+    if(laser_coeff->two_pt_correction_available[line] != 0)
+    {
+        Point out;
+        convLRDI2XYZI(input_PointLRDI,out);
+        output_Point3II.x = (int)lround(out.x * unit);
+        output_Point3II.y = (int)lround(out.y * unit);
+        output_Point3II.z = (int)lround(out.z * unit);
+        output_Point3II.intensity = out.intensity;
+        return 1;
+    }
+    convPointInt(int_coeff[unit == INT_UNIT_MM ? 1 : 0],line,cos_rot_table_q15[input_PointLRDI->rot_angle],
+                 sin_rot_table_q15[input_PointLRDI->rot_angle],input_PointLRDI->distance,input_PointLRDI->intensity,output_Point3II);
+    return 1;
+}
+
+template <typename Real>
+void VeloCalibT<Real>::convBlock(const unsigned short *distance, const unsigned char *intensity,
+                                 unsigned short upper_or_lower, unsigned short rot_angle, PointCloud &cloud, int unit)
+{
+    int line_base = upper_or_lower == LOWER_BLOCK ? 32 : 0;
+    unsigned int keep = filter_raw ? filterBlock(filter,filter_count,distance,line_base,rot_angle) : 0xFFFFFFFF;
+    if(keep == 0)
+    {
+        return;
+    }
+    const LaserCoeffInt & coeff = int_coeff[unit == INT_UNIT_MM ? 1 : 0];
+    if(conv_level == CALIB_AVX2 && !two_pt_any)
+    {
+        convBlockIntAVX2(coeff,cos_rot_table_q15[rot_angle],sin_rot_table_q15[rot_angle],
+                         distance,intensity,line_base,keep,filter_count,cloud);
+        return;
+    }
+    PointLRDI point;
+    point.rot_angle = rot_angle;
+    for(int k = 0; k < 32; k++)
+    {
+        if(((keep >> k) & 1) == 0)
+        {
+            continue;
+        }
+        int line = line_base + k;
+        int & n = cloud.line_point_num[line];
+        if(n >= cloud.max_line_point)
+        {
+            continue;
+        }
+        point.line_id = line;
+        point.distance = distance[k];
+        point.intensity = intensity[k];
+        Point3II & out = cloud.line_point_cloud[line][n];
+        if(convLRDI2XYZII(&point,out,unit) && filterRegion(coeff,filter_count,out.x,out.y,out.z))
+        {
+            n ++;
+        }
+    }
+}
+
+template <typename Real>
+int VeloCalibT<Real>::convFrame(const FrameData *frame, PointCloud &cloud, int unit)
+{
+    unsigned short distance[32];
+    unsigned char intensity[32];
+    for(unsigned int i = 0; i < frame->block_num; i++)
+    {
+        const Block & block = frame->frame_block[i];
+        for(int k = 0; k < 32; k++)
+        {
+            distance[k] = (unsigned short)block.fire_laser[k].distance;
+            intensity[k] = block.fire_laser[k].intensity;
+        }
+        convBlock(distance,intensity,block.upper_or_lower,block.rot_angle,cloud,unit);
+    }
+    int point_num = 0;
+    for(int i = 0; i < LASER_NUM; i++)
+    {
+        point_num += cloud.line_point_num[i];
+    }
+    return point_num;
+}
+
+template <typename Real>
+int VeloCalibT<Real>::convFrame(const CompactFrame *compact, PointCloud &cloud, int unit)
+{
+    for(unsigned int i = 0; i < compact->block_num; i++)
+    {
+        convBlock(compact->distance[i],compact->intensity[i],compact->upper_or_lower[i],compact->rot_angle[i],cloud,unit);
+    }
+    int point_num = 0;
+    for(int i = 0; i < LASER_NUM; i++)
+    {
+        point_num += cloud.line_point_num[i];
+    }
+    return point_num;
+}
+
+template <typename Real>
+int VeloCalibT<Real>::convLRDI2XYZI(const unsigned char *line_id, const unsigned short *rot_angle,
+                             const unsigned short *distance, const unsigned char *intensity,
+                             int num, Cloud &cloud)
+{
+    int i = 0;
+    if(conv_level == CALIB_AVX2)
+    {
+        i = convPointsAVX2(*laser_coeff,cos_rot_table,sin_rot_table,trig_table,line_id,rot_angle,distance,intensity,num,
+                           filter_raw ? &filter : nullptr,filter_count,cloud);
+    }
+    PointLRDI point;
+    Point out;
+    for(; i < num && cloud.point_num < cloud.max_point_num; i++)
+    {
+        point.line_id = line_id[i];
+        point.rot_angle = rot_angle[i];
+        point.distance = distance[i];
+        point.intensity = intensity[i];
+        if(filter_raw && !filterPoint(filter,filter_count,point.line_id,point.rot_angle,point.distance))
+        {
+            continue;
+        }
+        if(convLRDI2XYZI(&point,out) && filterRegion(*laser_coeff,filter_count,out.x,out.y,out.z))
+        {
+            unsigned int n = cloud.point_num ++;
+            cloud.x[n] = out.x;
+            cloud.y[n] = out.y;
+            cloud.z[n] = out.z;
+            cloud.intensity[n] = out.intensity;
+            cloud.line_id[n] = point.line_id;
+        }
+    }
+    return cloud.point_num;
+}
+
+template <typename Real>
+int VeloCalibT<Real>::setLevel(int level)
+{
+    __builtin_cpu_init();
+    int cpu_level = (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) ? CALIB_AVX2 : CALIB_SCALAR;
+    if(level == CALIB_AUTO || level > cpu_level)
+    {
+        level = cpu_level;
+    }
+    conv_level = level;
+    return conv_level;
+}
+
+template <typename Real>
+long VeloCalibT<Real>::setTrigTable(int format, int azimuth_step)
+{
+    free(trig_table.table);
+    memset(&trig_table,0,sizeof(trig_table));
+    if(format == TRIG_TABLE_OFF)
+    {
+        return 0;
+    }
+    if((format != TRIG_TABLE_FLOAT && format != TRIG_TABLE_INT16) || azimuth_step < 1 || 36000 % azimuth_step != 0)
+    {
+        printf("ERRO:trig table format %d, azimuth step %d must divide 36000\n",format,azimuth_step);
+        return -1;
+    }
+    int column_num = 36000 / azimuth_step;
+    size_t entry_num = (size_t)column_num * 2 * LASER_NUM;
+    size_t entry_size = format == TRIG_TABLE_FLOAT ? sizeof(float) : sizeof(short);
+    //one more entry for the 32 bit gathers of the int16 table
+    size_t bytes = (entry_num + 1) * entry_size;
+    void * buf = nullptr;
+    if(posix_memalign(&buf,64,bytes) != 0)
+    {
+        printf("ERRO:no memory for the trig table (%zu bytes)\n",bytes);
+        return -1;
+    }
+    memset(buf,0,bytes);
+    for(int column = 0; column < column_num; column++)
+    {
+        double angle = column * azimuth_step * M_PI / 180.0 / 100.0;
+        double cos_azimuth = cos(angle);
+        double sin_azimuth = sin(angle);
+        for(int i = 0; i < LASER_NUM; i++)
+        {
+            double cos_rot_angle = cos_azimuth * in_param[i].cos_rot_correction + sin_azimuth * in_param[i].sin_rot_correction;
+            double sin_rot_angle = sin_azimuth * in_param[i].cos_rot_correction - cos_azimuth * in_param[i].sin_rot_correction;
+            size_t index = (size_t)column * 2 * LASER_NUM + i;
+            if(format == TRIG_TABLE_FLOAT)
+            {
+                ((float *)buf)[index] = (float)cos_rot_angle;
+                ((float *)buf)[index + LASER_NUM] = (float)sin_rot_angle;
+            }
+            else
+            {
+                ((short *)buf)[index] = (short)fmax(-32768.0,fmin(32767.0,lround(cos_rot_angle * 32768)));
+                ((short *)buf)[index + LASER_NUM] = (short)fmax(-32768.0,fmin(32767.0,lround(sin_rot_angle * 32768)));
+            }
+        }
+    }
+    trig_table.format = format;
+    trig_table.azimuth_step = azimuth_step;
+    trig_table.column_num = column_num;
+    trig_table.table = buf;
+    return (long)bytes;
+}
+
+template <typename Real>
+void VeloCalibT<Real>::createTable()
+{
+    const VeloTrigTable<Real> & table = veloTrigTable((const Real *)nullptr);
+    cos_rot_table = table.cos_rot_table;
+    sin_rot_table = table.sin_rot_table;
+    cos_rot_table_q15 = table.cos_rot_table_q15;
+    sin_rot_table_q15 = table.sin_rot_table_q15;
+}
+
+template <typename Real>
+void VeloCalibT<Real>::createCoeff()
+{
+    two_pt_any = false;
+    for(int i=0;i<LASER_NUM;i++)
+    {
+        in_param[i].cos_rot_correction = cos(M_PI/180.0*in_param[i].rot_correction);
+        in_param[i].cos_vert_correction = cos(M_PI/180.0*in_param[i].vert_correction);
+        in_param[i].sin_vert_correction = sin(M_PI/180.0*in_param[i].vert_correction);
+        in_param[i].sin_rot_correction = sin(M_PI/180.0*in_param[i].rot_correction);
+
+        //compile the per laser terms of convLRDI2XYZIRef into the coefficient block
+        const LaserCorrection & corr = in_param[i];
+        double resolution = DISTANCE_RESOLUTION;
+        double focal_term = 1 - corr.focal_distance / 13100;
+        laser_coeff->cos_rot_correction[i] = corr.cos_rot_correction;
+        laser_coeff->sin_rot_correction[i] = corr.sin_rot_correction;
+        laser_coeff->horiz_offset_correction[i] = corr.horiz_offset_correction;
+        laser_coeff->xy_scale[i] = resolution * corr.cos_vert_correction;
+        laser_coeff->xy_offset[i] = corr.dist_correction * corr.cos_vert_correction - corr.vert_offset_correction * corr.sin_vert_correction;
+        laser_coeff->z_scale[i] = resolution * corr.sin_vert_correction;
+        laser_coeff->z_offset[i] = corr.dist_correction * corr.sin_vert_correction + corr.vert_offset_correction * corr.cos_vert_correction;
+        laser_coeff->cos_vert_correction[i] = corr.cos_vert_correction;
+        laser_coeff->sin_vert_correction[i] = corr.sin_vert_correction;
+        laser_coeff->two_pt_slope_x[i] = (corr.dist_correction - corr.dist_correction_x) / (2504 - 240);
+        laser_coeff->two_pt_offset_x[i] = corr.dist_correction_x - corr.dist_correction - 240 * laser_coeff->two_pt_slope_x[i];
+        laser_coeff->two_pt_slope_y[i] = (corr.dist_correction - corr.dist_correction_y) / (2504 - 193);
+        laser_coeff->two_pt_offset_y[i] = corr.dist_correction_y - corr.dist_correction - 193 * laser_coeff->two_pt_slope_y[i];
+        laser_coeff->two_pt_correction_available[i] = corr.two_pt_correction_available ? 1 : 0;
+        laser_coeff->focal_offset[i] = 256 * focal_term * focal_term;
+        laser_coeff->focal_slope[i] = corr.focal_slope;
+        laser_coeff->min_intensity[i] = corr.min_intensity;
+        laser_coeff->max_intensity[i] = corr.max_intensity;
+        two_pt_any = two_pt_any || corr.two_pt_correction_available;
+
+        //the same terms in fixed point, lanes in 1/16 of the output unit
+        for(int u = 0; u < 2; u++)
+        {
+            LaserCoeffInt & coeff_int = int_coeff[u];
+            double lane_unit = 16.0 * (u == 0 ? INT_UNIT_CM : INT_UNIT_MM);
+            double xy_offset = corr.dist_correction * corr.cos_vert_correction - corr.vert_offset_correction * corr.sin_vert_correction;
+            double z_offset = corr.dist_correction * corr.sin_vert_correction + corr.vert_offset_correction * corr.cos_vert_correction;
+            coeff_int.cos_rot_correction[i] = (int)fmin(32767.0,lround(corr.cos_rot_correction * 32768));
+            coeff_int.sin_rot_correction[i] = (int)lround(corr.sin_rot_correction * 32768);
+            coeff_int.horiz_offset_correction[i] = (int)lround(corr.horiz_offset_correction * lane_unit);
+            coeff_int.xy_scale[i] = (int)lround(resolution * corr.cos_vert_correction * lane_unit * 65536);
+            coeff_int.xy_offset[i] = (int)lround(xy_offset * lane_unit * 256) + 128;
+            coeff_int.z_scale[i] = (int)lround(resolution * corr.sin_vert_correction * lane_unit * 65536);
+            coeff_int.z_offset[i] = (int)lround(z_offset * lane_unit * 256) + 128;
+            coeff_int.focal_offset[i] = (int)lround(256 * focal_term * focal_term * 1024);
+            coeff_int.focal_slope[i] = (int)lround(corr.focal_slope * 16384);
+            coeff_int.min_intensity[i] = corr.min_intensity;
+            coeff_int.max_intensity[i] = corr.max_intensity;
+        }
+    }
+    createExtrinsic();
+}
+
+template <typename Real>
+void VeloCalibT<Real>::createExtrinsic()
+{
+    bool identity = true;
+    for(int row = 0; row < 3; row++)
+    {
+        for(int col = 0; col < 3; col++)
+        {
+            identity = identity && extrinsic.rotation[row][col] == (row == col ? 1.0 : 0.0);
+        }
+        identity = identity && extrinsic.translation[row] == 0;
+    }
+    laser_coeff->extrinsic_available = identity ? 0 : 1;
+    for(int u = 0; u < 2; u++)
+    {
+        int_coeff[u].extrinsic_available = identity ? 0 : 1;
+    }
+    for(int row = 0; row < 3; row++)
+    {
+        for(int col = 0; col < 3; col++)
+        {
+            laser_coeff->extrinsic[row * 4 + col] = extrinsic.rotation[row][col];
+            for(int u = 0; u < 2; u++)
+            {
+                int_coeff[u].extrinsic[row * 4 + col] = (int)fmax(-32768.0,fmin(32767.0,lround(extrinsic.rotation[row][col] * 32768)));
+            }
+        }
+        laser_coeff->extrinsic[row * 4 + 3] = extrinsic.translation[row];
+        for(int u = 0; u < 2; u++)
+        {
+            double lane_unit = 16.0 * (u == 0 ? INT_UNIT_CM : INT_UNIT_MM);
+            int_coeff[u].extrinsic[row * 4 + 3] = (int)lround(extrinsic.translation[row] * lane_unit);
+        }
+    }
+}
+
+template <typename Real>
+int VeloCalibT<Real>::setExtrinsic(const double matrix[4][4])
+{
+    if(matrix == nullptr)
+    {
+        extrinsic = xml_extrinsic;
+    }
+    else
+    {
+        for(int row = 0; row < 3; row++)
+        {
+            for(int col = 0; col < 3; col++)
+            {
+                extrinsic.rotation[row][col] = matrix[row][col];
+            }
+            extrinsic.translation[row] = matrix[row][3];
+        }
+    }
+    createExtrinsic();
+    return laser_coeff->extrinsic_available;
+}
+
+template <typename Real>
+void VeloCalibT<Real>::defaultFilter(CalibFilter &filter)
+{
+    memset(&filter,0,sizeof(filter));
+    filter.min_distance = 0;
+    filter.max_distance = 65535;
+    filter.sector_num = 0;
+    filter.laser_mask = ~0ULL;
+    filter.region_enable = 0;
+    filter.body_enable = 0;
+}
+
+template <typename Real>
+void VeloCalibT<Real>::createFilter()
+{
+    filter_raw = filter.min_distance > 1 || filter.max_distance < 65535 ||
+                 filter.sector_num > 0 || filter.laser_mask != ~0ULL;
+    laser_coeff->region_available = filter.region_enable ? 1 : 0;
+    laser_coeff->body_available = filter.body_enable ? 1 : 0;
+    for(int u = 0; u < 2; u++)
+    {
+        int_coeff[u].region_available = laser_coeff->region_available;
+        int_coeff[u].body_available = laser_coeff->body_available;
+    }
+    for(int i = 0; i < 6; i++)
+    {
+        laser_coeff->region[i] = filter.region[i];
+        laser_coeff->body[i] = filter.body[i];
+        for(int u = 0; u < 2; u++)
+        {
+            int unit = u == 0 ? INT_UNIT_CM : INT_UNIT_MM;
+            int_coeff[u].region[i] = (int)fmax(-2e9,fmin(2e9,lround(filter.region[i] * unit)));
+            int_coeff[u].body[i] = (int)fmax(-2e9,fmin(2e9,lround(filter.body[i] * unit)));
+        }
+    }
+}
+
+template <typename Real>
+int VeloCalibT<Real>::setFilter(const CalibFilter *filter)
+{
+    if(filter == nullptr)
+    {
+        defaultFilter(this->filter);
+        createFilter();
+        return 0;
+    }
+    if(filter->sector_num < 0 || filter->sector_num > FILTER_SECTOR_MAX)
+    {
+        printf("ERRO:%d filter sectors, at most %d\n",filter->sector_num,FILTER_SECTOR_MAX);
+        return -1;
+    }
+    for(int i = 0; i < filter->sector_num; i++)
+    {
+        if(filter->sector_start[i] > 36000 || filter->sector_end[i] > 36000)
+        {
+            printf("ERRO:filter sector %d [%d,%d) is out of 0 to 36000\n",i,filter->sector_start[i],filter->sector_end[i]);
+            return -1;
+        }
+    }
+    this->filter = *filter;
+    createFilter();
+    return filter_raw || laser_coeff->region_available || laser_coeff->body_available ? 1 : 0;
+}
+
+//us from ref to time on the hour clock of gps_time_stampe, within half an hour either way
+static inline double hourGap(unsigned int time, unsigned int ref)
+{
+    double gap = (double)time - (double)ref;
+    return gap >= 1800e6 ? gap - 3600e6 : (gap < -1800e6 ? gap + 3600e6 : gap);
+}
+
+//c = a * b of 3x3 row major matrices, c is not a or b
+static inline void mulMatrix3(const double * a, const double * b, double * c)
+{
+    for(int row = 0; row < 3; row++)
+    {
+        for(int col = 0; col < 3; col++)
+        {
+            c[row * 3 + col] = a[row * 3] * b[col] + a[row * 3 + 1] * b[3 + col] + a[row * 3 + 2] * b[6 + col];
+        }
+    }
+}
+
+//pose of the segments gap us from the reference time, rotation (3x3 row major) and translation (cm)
+static void segmentPose(const DeskewSegment * segment, int segment_num, double gap, double * rotation, double * translation)
+{
+    //last segment starting before the gap, the first one before all of them
+    int l = 0;
+    int r = segment_num - 1;
+    while(l < r)
+    {
+        int m = (l + r + 1) / 2;
+        if(segment[m].start <= gap)
+        {
+            l = m;
+        }
+        else
+        {
+            r = m - 1;
+        }
+    }
+    const DeskewSegment & seg = segment[l];
+    double a = (gap - seg.start) / seg.duration;
+    //sin and 1 - cos of the angle turned, the series below 0.05 rad within 1e-13
+    double x = a * seg.angle;
+    double sin_x;
+    double cos_x1;
+    if(fabs(x) < 0.05)
+    {
+        double x2 = x * x;
+        sin_x = x * (1 - x2 / 6 * (1 - x2 / 20));
+        cos_x1 = x2 / 2 * (1 - x2 / 12 * (1 - x2 / 30));
+    }
+    else
+    {
+        sin_x = sin(x);
+        cos_x1 = 1 - cos(x);
+    }
+    double turn[9];
+    for(int k = 0; k < 9; k++)
+    {
+        turn[k] = (k % 4 == 0 ? 1.0 : 0.0) + sin_x * seg.axis[k] + cos_x1 * seg.axis2[k];
+    }
+    mulMatrix3(seg.rotation,turn,rotation);
+    for(int k = 0; k < 3; k++)
+    {
+        translation[k] = seg.translation[k] + a * seg.velocity[k];
+    }
+}
+
+template <typename Real>
+int VeloCalibT<Real>::setDeskew(const EgoPose *poses, int pose_num, unsigned int ref_time)
+{
+    if(poses == nullptr)
+    {
+        delete [] deskew_segment;
+        deskew_segment = nullptr;
+        deskew_segment_num = 0;
+        return 0;
+    }
+    if(pose_num < 2)
+    {
+        printf("ERRO:%d ego poses, the de-skew needs 2 at least\n",pose_num);
+        return -1;
+    }
+    for(int i = 1; i < pose_num; i++)
+    {
+        if(hourGap(poses[i].time,poses[i - 1].time) <= 0)
+        {
+            printf("ERRO:ego pose %d at %u us is not after the one before\n",i,poses[i].time);
+            return -1;
+        }
+    }
+
+    //stp1. motion of every segment in the odometry frame: the rotation between its poses
+    //as an angle around a unit axis, the translation as a velocity
+    int segment_num = pose_num - 1;
+    DeskewSegment * segment = new DeskewSegment[segment_num];
+    for(int i = 0; i < segment_num; i++)
+    {
+        Extrinsic pose0;
+        Extrinsic pose1;
+        extrinsicFromPose(poses[i].position,poses[i].rpy,pose0);
+        extrinsicFromPose(poses[i + 1].position,poses[i + 1].rpy,pose1);
+        DeskewSegment & seg = segment[i];
+        seg.start = hourGap(poses[i].time,ref_time);
+        seg.duration = hourGap(poses[i + 1].time,poses[i].time);
+        double turn[9];
+        for(int row = 0; row < 3; row++)
+        {
+            for(int col = 0; col < 3; col++)
+            {
+                seg.rotation[row * 3 + col] = pose0.rotation[row][col];
+                turn[row * 3 + col] = pose0.rotation[0][row] * pose1.rotation[0][col] +
+                                      pose0.rotation[1][row] * pose1.rotation[1][col] +
+                                      pose0.rotation[2][row] * pose1.rotation[2][col];
+            }
+            seg.translation[row] = pose0.translation[row];
+            seg.velocity[row] = pose1.translation[row] - pose0.translation[row];
+        }
+        double w[3] = {(turn[7] - turn[5]) / 2,(turn[2] - turn[6]) / 2,(turn[3] - turn[1]) / 2};
+        double sin_angle = sqrt(w[0] * w[0] + w[1] * w[1] + w[2] * w[2]);
+        seg.angle = atan2(sin_angle,(turn[0] + turn[4] + turn[8] - 1) / 2);
+        double u[3] = {0,0,0};
+        for(int k = 0; k < 3 && sin_angle > 1e-12; k++)
+        {
+            u[k] = w[k] / sin_angle;
+        }
+        double axis[9] = {0,-u[2],u[1], u[2],0,-u[0], -u[1],u[0],0};
+        memcpy(seg.axis,axis,sizeof(axis));
+        mulMatrix3(axis,axis,seg.axis2);
+    }
+
+    //stp2. every segment seen from the vehicle at ref_time
+    double ref_rotation[9];
+    double ref_translation[3];
+    segmentPose(segment,segment_num,0,ref_rotation,ref_translation);
+    double ref_inverse[9];
+    for(int row = 0; row < 3; row++)
+    {
+        for(int col = 0; col < 3; col++)
+        {
+            ref_inverse[row * 3 + col] = ref_rotation[col * 3 + row];
+        }
+    }
+    for(int i = 0; i < segment_num; i++)
+    {
+        DeskewSegment & seg = segment[i];
+        double rotation[9];
+        mulMatrix3(ref_inverse,seg.rotation,rotation);
+        memcpy(seg.rotation,rotation,sizeof(rotation));
+        double translation[3];
+        double velocity[3];
+        for(int row = 0; row < 3; row++)
+        {
+            translation[row] = 0;
+            velocity[row] = 0;
+            for(int k = 0; k < 3; k++)
+            {
+                translation[row] += ref_inverse[row * 3 + k] * (seg.translation[k] - ref_translation[k]);
+                velocity[row] += ref_inverse[row * 3 + k] * seg.velocity[k];
+            }
+        }
+        memcpy(seg.translation,translation,sizeof(translation));
+        memcpy(seg.velocity,velocity,sizeof(velocity));
+    }
+    delete [] deskew_segment;
+    deskew_segment = segment;
+    deskew_segment_num = segment_num;
+    deskew_ref_time = ref_time;
+    return 1;
+}
+
+/** @brief transform of the points of a block fired at time_stampe: the extrinsic, or with the
+ *  de-skew the pose of that time composed with it, made once for the blocks of a firing
+ *  @param gps_time_stampe of the block
+ *  @param 12 values for the de-skewed transform
+ *  @param time of the transform in extrinsic_buf
+ *  @return rows of rotation | translation, nullptr for the identity
+ */
+template <typename Real>
+const Real * VeloCalibT<Real>::blockExtrinsic(unsigned int time_stampe, Real *extrinsic_buf, unsigned int &buf_time)
+{
+    if(deskew_segment_num == 0)
+    {
+        return laser_coeff->extrinsic_available ? laser_coeff->extrinsic : nullptr;
+    }
+    if(time_stampe != buf_time)
+    {
+        double rotation[9];
+        double translation[3];
+        segmentPose(deskew_segment,deskew_segment_num,hourGap(time_stampe,deskew_ref_time),rotation,translation);
+        for(int row = 0; row < 3; row++)
+        {
+            const double * r = rotation + row * 3;
+            for(int col = 0; col < 3; col++)
+            {
+                extrinsic_buf[row * 4 + col] = (Real)(r[0] * extrinsic.rotation[0][col] + r[1] * extrinsic.rotation[1][col] +
+                                                      r[2] * extrinsic.rotation[2][col]);
+            }
+            extrinsic_buf[row * 4 + 3] = (Real)(r[0] * extrinsic.translation[0] + r[1] * extrinsic.translation[1] +
+                                                r[2] * extrinsic.translation[2] + translation[row]);
+        }
+        buf_time = time_stampe;
+    }
+    return extrinsic_buf;
+}
+
+template <typename Real>
+int VeloCalibT<Real>::readFile(char *file_dir)
+{
+    tinyxml2::XMLDocument* doc = new tinyxml2::XMLDocument();
+    doc->LoadFile( file_dir );
+    int erro_id = doc->ErrorID();
+    if(erro_id==tinyxml2::XML_SUCCESS)
+    {
+        printf("LOG:XML_SUCCESS\n");
+    }
+    if(erro_id==tinyxml2::XML_ERROR_FILE_NOT_FOUND)
+    {
+        printf("ERO:XML_ERROR_FILE_NOT_FOUND\n");
+        return 0;
+    }
+    if(erro_id==tinyxml2::XML_ERROR_FILE_COULD_NOT_BE_OPENED)
+    {
+        printf("ERO:XML_ERROR_FILE_COULD_NOT_BE_OPENED\n");
+        return 0;
+    }
+    if(erro_id==tinyxml2::XML_ERROR_FILE_READ_ERROR)
+    {
+        printf("ERO:XML_ERROR_FILE_READ_ERROR\n");
+        return 0;
+    }
+    tinyxml2::XMLElement * db = doc->RootElement()->FirstChildElement("DB");
+    //position_ and orientation_ of the sensor, the identity when they are missing
+    double position[3] = {0,0,0};
+    double rpy[3] = {0,0,0};
+    tinyxml2::XMLElement * xyz = db->FirstChildElement("position_");
+    tinyxml2::XMLElement * angle = db->FirstChildElement("orientation_");
+    xyz = xyz != nullptr && xyz->FirstChildElement("xyz") != nullptr ? xyz->FirstChildElement("xyz")->FirstChildElement("item") : nullptr;
+    angle = angle != nullptr && angle->FirstChildElement("rpy") != nullptr ? angle->FirstChildElement("rpy")->FirstChildElement("item") : nullptr;
+    for(int i = 0; i < 3 && xyz != nullptr; i++, xyz = xyz->NextSiblingElement("item"))
+    {
+        position[i] = xyz->DoubleText();
+    }
+    for(int i = 0; i < 3 && angle != nullptr; i++, angle = angle->NextSiblingElement("item"))
+    {
+        rpy[i] = angle->DoubleText();
+    }
+    extrinsicFromPose(position,rpy,xml_extrinsic);
+    extrinsic = xml_extrinsic;
+    if(print_param)
+    {
+        printf("position:%.3f %.3f %.3f orientation:%.3f %.3f %.3f\n",position[0],position[1],position[2],rpy[0],rpy[1],rpy[2]);
+    }
+    tinyxml2::XMLElement * min_intensity = db->FirstChildElement("minIntensity_")->FirstChildElement("item");
+    tinyxml2::XMLElement * max_intensity = db->FirstChildElement("maxIntensity_")->FirstChildElement("item");
+    tinyxml2::XMLElement * points = db->FirstChildElement("points_")->FirstChildElement("item");
+    for(int i=0;i<LASER_NUM;i++)
+    {
+        in_param[i].min_intensity = min_intensity->IntText();
+        in_param[i].max_intensity = max_intensity->IntText();
+        in_param[i].rot_correction = points->FirstChild()->
+                FirstChildElement("rotCorrection_")->DoubleText();
+        in_param[i].vert_correction = points->FirstChild()->
+                FirstChildElement("vertCorrection_")->DoubleText();
+        in_param[i].dist_correction = points->FirstChild()->
+                FirstChildElement("distCorrection_")->DoubleText();
+        in_param[i].dist_correction_x = points->FirstChild()->
+                FirstChildElement("distCorrectionX_")->DoubleText();
+        in_param[i].dist_correction_y = points->FirstChild()->
+                FirstChildElement("distCorrectionY_")->DoubleText();
+        in_param[i].vert_offset_correction = points->FirstChild()->
+                FirstChildElement("vertOffsetCorrection_")->DoubleText();
+        in_param[i].horiz_offset_correction = points->FirstChild()->
+                FirstChildElement("horizOffsetCorrection_")->DoubleText();
+        in_param[i].focal_distance = points->FirstChild()->
+                FirstChildElement("focalDistance_")->DoubleText();
+        in_param[i].focal_slope = points->FirstChild()->
+                FirstChildElement("focalSlope_")->DoubleText();
+
+        if(print_param)
+        {
+            printf("laser:%d \n",i);
+            printf("min_i:%03d max_i:%03d rot_corr:%.3f vert_corr:%.3f dist_corr:%.3f dist_corr_x:%.3f dist_corr_y:%.3f ",
+                   in_param[i].min_intensity,in_param[i].max_intensity,in_param[i].rot_correction,in_param[i].vert_correction,
+                   in_param[i].dist_correction,in_param[i].dist_correction_x,in_param[i].dist_correction_y);
+            printf("vert_offset:%.3f horiz_offset:%.3f focal_dist:%.3f focal_slope:%.3f\n",
+                   in_param[i].vert_offset_correction,in_param[i].horiz_offset_correction,
+                   in_param[i].focal_distance,in_param[i].focal_slope);
+        }
+
+        in_param[i].two_pt_correction_available = false;
+        scan_table[i].x = i;
+        scan_table[i].y = in_param[i].vert_correction;
+
+        min_intensity = min_intensity->NextSiblingElement();
+        max_intensity = max_intensity->NextSiblingElement();
+        points = points->NextSiblingElement();
+    }
+    delete doc;
+    return 1;
+}
+
+template <typename Real>
+int VeloCalibT<Real>::loadCache(const char *calib_file_dir, const char *cache_file_dir)
+{
+    int fd = open(cache_file_dir,O_RDONLY);
+    if(fd < 0)
+    {
+        return 0;
+    }
+    struct stat file_stat;
+    if(fstat(fd,&file_stat) != 0 || (size_t)file_stat.st_size < sizeof(CalibCacheHeader))
+    {
+        close(fd);
+        printf("WRN:calibration cache %s is broken, parsing the xml\n",cache_file_dir);
+        return 0;
+    }
+    size_t map_size = file_stat.st_size;
+    void * map = mmap(nullptr,map_size,PROT_READ,MAP_SHARED,fd,0);
+    close(fd);
+    if(map == MAP_FAILED)
+    {
+        printf("WRN:calibration cache %s can not be mapped, parsing the xml\n",cache_file_dir);
+        return 0;
+    }
+
+    //stp1. layout of this build
+    const CalibCacheHeader * header = (const CalibCacheHeader *)map;
+    const unsigned char * base = (const unsigned char *)map;
+    bool ok = memcmp(header->magic,"VELOCALB",8) == 0 &&
+            header->version == CALIB_CACHE_VERSION &&
+            header->correction_size == sizeof(LaserCorrection) &&
+            header->laser_num == LASER_NUM &&
+            header->file_size == map_size &&
+            header->in_param_offset + sizeof(in_param) <= map_size &&
+            header->scan_table_offset + sizeof(scan_table) <= map_size &&
+            header->extrinsic_offset + sizeof(xml_extrinsic) <= map_size;
+    //stp2. content
+    ok = ok && hashBytes(base + sizeof(CalibCacheHeader),map_size - sizeof(CalibCacheHeader)) == header->checksum;
+    if(!ok)
+    {
+        munmap(map,map_size);
+        printf("WRN:calibration cache %s is broken, parsing the xml\n",cache_file_dir);
+        return 0;
+    }
+    //stp3. the xml it was made from
+    unsigned long long xml_hash = 0;
+    unsigned long long xml_size = 0;
+    if(!hashFile(calib_file_dir,xml_hash,xml_size))
+    {
+        printf("WRN:%s can not be read, using calibration cache %s\n",calib_file_dir,cache_file_dir);
+    }
+    else if(xml_hash != header->xml_hash || xml_size != header->xml_size)
+    {
+        munmap(map,map_size);
+        printf("LOG:calibration cache %s is older than %s, parsing the xml\n",cache_file_dir,calib_file_dir);
+        return 0;
+    }
+
+    memcpy(in_param,base + header->in_param_offset,sizeof(in_param));
+    memcpy(scan_table,base + header->scan_table_offset,sizeof(scan_table));
+    memcpy(&xml_extrinsic,base + header->extrinsic_offset,sizeof(xml_extrinsic));
+    extrinsic = xml_extrinsic;
+    munmap(map,map_size);
+    printf("LOG:calibration cache %s loaded\n",cache_file_dir);
+    return 1;
+}
+
+template <typename Real>
+int VeloCalibT<Real>::saveCache(const char *calib_file_dir, const char *cache_file_dir)
+{
+    CalibCacheHeader header;
+    memset(&header,0,sizeof(header));
+    memcpy(header.magic,"VELOCALB",8);
+    header.version = CALIB_CACHE_VERSION;
+    header.correction_size = sizeof(LaserCorrection);
+    header.laser_num = LASER_NUM;
+    if(!hashFile(calib_file_dir,header.xml_hash,header.xml_size))
+    {
+        return 0;
+    }
+    header.in_param_offset = CALIB_CACHE_ALIGN(sizeof(CalibCacheHeader));
+    header.scan_table_offset = CALIB_CACHE_ALIGN(header.in_param_offset + sizeof(in_param));
+    header.extrinsic_offset = CALIB_CACHE_ALIGN(header.scan_table_offset + sizeof(scan_table));
+    header.file_size = header.extrinsic_offset + sizeof(xml_extrinsic);
+
+    unsigned char * buf = new unsigned char[header.file_size];
+    memset(buf,0,header.file_size);
+    memcpy(buf + header.in_param_offset,in_param,sizeof(in_param));
+    memcpy(buf + header.scan_table_offset,scan_table,sizeof(scan_table));
+    memcpy(buf + header.extrinsic_offset,&xml_extrinsic,sizeof(xml_extrinsic));
+    header.checksum = hashBytes(buf + sizeof(CalibCacheHeader),header.file_size - sizeof(CalibCacheHeader));
+    memcpy(buf,&header,sizeof(header));
+
+    //a new file renamed over the old one, processes still mapping the old one keep it
+    char temp_dir[4096];
+    snprintf(temp_dir,sizeof(temp_dir),"%s.%d.tmp",cache_file_dir,(int)getpid());
+    FILE * fp = fopen(temp_dir,"wb");
+    bool ok = fp != nullptr;
+    if(ok)
+    {
+        ok = fwrite(buf,1,header.file_size,fp) == header.file_size;
+        ok = fclose(fp) == 0 && ok;
+    }
+    delete [] buf;
+    if(!ok || rename(temp_dir,cache_file_dir) != 0)
+    {
+        remove(temp_dir);
+        printf("WRN:calibration cache %s can not be written\n",cache_file_dir);
+        return 0;
+    }
+    printf("LOG:calibration cache %s written\n",cache_file_dir);
+    return 1;
+}
+
+template <typename Real>
+void VeloCalibT<Real>::quickSort(Point2F *s, int l, int r)
+{
+    if (l < r)
+    {
+        int i = l, j = r;
+        Point2F x = s[l];
         while (i < j)
         {
             while(i < j && s[j].y >= x.y)
@@ -262,5 +2803,5 @@ void VeloCalib::quickSort(Point2F *s, int l, int r)
     }
 }
 
-
-
+template class VeloCalibT<double>;
+template class VeloCalibT<float>;
@@ -0,0 +1,196 @@
+#include "velo_decoder.h"
+#include <string.h>
+#include <immintrin.h>
+
+//byte layout of a block: 2 bytes block id, 2 bytes rotation angle, 32 x 3 bytes lasers
+#define BLOCK_SIZE      100
+#define BLOCK_HEAD_SIZE 4
+
+static inline void decodeHead(const unsigned char * block, unsigned short * upper_or_lower, unsigned short * rot_angle)
+{
+    *upper_or_lower = (block[1]<<8) + block[0];
+    *rot_angle = (block[3]<<8) + block[2];
+}
+
+static void decodeBlocksScalar(const unsigned char * packet, int block_num,
+                               unsigned short (*distance)[32], unsigned char (*intensity)[32],
+                               unsigned short * upper_or_lower, unsigned short * rot_angle)
+{
+    for(int b = 0; b < block_num; b++)
+    {
+        const unsigned char * p_data = packet + b * BLOCK_SIZE;
+        decodeHead(p_data,&upper_or_lower[b],&rot_angle[b]);
+        p_data += BLOCK_HEAD_SIZE;
+        for(int laser_index = 0; laser_index < 32; laser_index++)
+        {
+            distance[b][laser_index] = (p_data[1] << 8) + p_data[0];
+            intensity[b][laser_index] = p_data[2];
+            p_data += 3;
+        }
+    }
+}
+
+//4 lasers (12 bytes) -> 4 distances in bytes 0-7, 4 intensities in bytes 8-11.
+//the 16 bytes loads of the last lasers read into the next block or the
+//packet tail, which is always inside the 1206 bytes packet
+#define LASER_SHUFFLE 0,1,3,4,6,7,9,10,2,5,8,11,-1,-1,-1,-1
+
+__attribute__((target("sse4.1")))
+static void decodeBlocksSSE41(const unsigned char * packet, int block_num,
+                              unsigned short (*distance)[32], unsigned char (*intensity)[32],
+                              unsigned short * upper_or_lower, unsigned short * rot_angle)
+{
+    const __m128i shuffle = _mm_setr_epi8(LASER_SHUFFLE);
+    for(int b = 0; b < block_num; b++)
+    {
+        const unsigned char * p_data = packet + b * BLOCK_SIZE;
+        decodeHead(p_data,&upper_or_lower[b],&rot_angle[b]);
+        p_data += BLOCK_HEAD_SIZE;
+        //8 lasers per step
+        for(int k = 0; k < 4; k++)
+        {
+            __m128i lo = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(p_data + 24 * k)),shuffle);
+            __m128i hi = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(p_data + 24 * k + 12)),shuffle);
+            _mm_storeu_si128((__m128i *)&distance[b][8 * k],_mm_unpacklo_epi64(lo,hi));
+            _mm_storel_epi64((__m128i *)&intensity[b][8 * k],_mm_unpackhi_epi32(lo,hi));
+        }
+    }
+}
+
+__attribute__((target("avx2")))
+static inline __m256i loadLasers8(const unsigned char * p_data)
+{
+    //lasers 0-3 in the low lane, lasers 4-7 in the high lane
+    return _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128((const __m128i *)p_data)),
+                                   _mm_loadu_si128((const __m128i *)(p_data + 12)),1);
+}
+
+__attribute__((target("avx2")))
+static void decodeBlocksAVX2(const unsigned char * packet, int block_num,
+                             unsigned short (*distance)[32], unsigned char (*intensity)[32],
+                             unsigned short * upper_or_lower, unsigned short * rot_angle)
+{
+    const __m256i shuffle = _mm256_setr_epi8(LASER_SHUFFLE,LASER_SHUFFLE);
+    const __m256i gather_intensity = _mm256_setr_epi32(0,4,1,5,2,3,6,7);
+    for(int b = 0; b < block_num; b++)
+    {
+        const unsigned char * p_data = packet + b * BLOCK_SIZE;
+        decodeHead(p_data,&upper_or_lower[b],&rot_angle[b]);
+        p_data += BLOCK_HEAD_SIZE;
+        //16 lasers per step
+        for(int k = 0; k < 2; k++)
+        {
+            __m256i lo = _mm256_shuffle_epi8(loadLasers8(p_data + 48 * k),shuffle);
+            __m256i hi = _mm256_shuffle_epi8(loadLasers8(p_data + 48 * k + 24),shuffle);
+            //[d0-3 d8-11 | d4-7 d12-15] -> d0-15
+            __m256i dist = _mm256_permute4x64_epi64(_mm256_unpacklo_epi64(lo,hi),0xd8);
+            //[i0-3 i8-11 . . | i4-7 i12-15 . .] -> i0-15
+            __m256i inten = _mm256_permutevar8x32_epi32(_mm256_unpackhi_epi32(lo,hi),gather_intensity);
+            _mm256_storeu_si256((__m256i *)&distance[b][16 * k],dist);
+            _mm_storeu_si128((__m128i *)&intensity[b][16 * k],_mm256_castsi256_si128(inten));
+        }
+    }
+}
+
+//factory bytes of the 32E and the VLP-16
+#define FACTORY_STRONGEST   0x37
+#define FACTORY_LAST        0x38
+#define FACTORY_DUAL        0x39
+#define FACTORY_HDL32E      0x21
+#define FACTORY_VLP16       0x22
+
+template <int Model>
+static SensorLayout layoutOf()
+{
+    typedef SensorTraits<Model> Traits;
+    SensorLayout layout = {Traits::laser_num,Traits::block_per_firing,Traits::firing_per_block,
+                           Traits::firing_period,Traits::block_rate};
+    return layout;
+}
+
+const SensorLayout & sensorLayout(int model)
+{
+    static const SensorLayout layouts[MODEL_NUM] = {layoutOf<MODEL_HDL64E>(),layoutOf<MODEL_HDL32E>(),layoutOf<MODEL_VLP16>()};
+    return layouts[model > MODEL_UNKNOWN && model < MODEL_NUM ? model : MODEL_HDL64E];
+}
+
+int detectSensor(const unsigned char *packet, SensorInfo &info)
+{
+    info.model = MODEL_UNKNOWN;
+    info.return_mode = RETURN_STRONGEST;
+    bool lower = false;
+    for(int b = 0; b < 12; b++)
+    {
+        unsigned short upper_or_lower;
+        unsigned short rot_angle;
+        decodeHead(packet + b * BLOCK_SIZE,&upper_or_lower,&rot_angle);
+        if(upper_or_lower != 0xEEFF && upper_or_lower != 0xDDFF)
+        {
+            return 0;
+        }
+        lower = lower || upper_or_lower == 0xDDFF;
+    }
+    const unsigned char * p_tail = packet + 12 * BLOCK_SIZE;
+    if(lower)
+    {
+        unsigned short head[2][2];
+        decodeHead(packet,&head[0][0],&head[0][1]);
+        decodeHead(packet + BLOCK_SIZE,&head[1][0],&head[1][1]);
+        info.model = MODEL_HDL64E;
+        info.return_mode = head[0][0] == head[1][0] && head[0][1] == head[1][1] ? RETURN_DUAL : RETURN_STRONGEST;
+        return 1;
+    }
+    info.model = p_tail[5] == FACTORY_VLP16 ? MODEL_VLP16 : MODEL_HDL32E;
+    info.return_mode = p_tail[4] == FACTORY_DUAL ? RETURN_DUAL : (p_tail[4] == FACTORY_LAST ? RETURN_LAST : RETURN_STRONGEST);
+    return 1;
+}
+
+/** @brief constructor
+ *  @param DECODER_SCALAR, DECODER_SSE41, DECODER_AVX2 or DECODER_AUTO,
+ *  a level the cpu lacks falls back to the best supported one
+ */
+VeloDecoder::VeloDecoder(int level)
+{
+    int cpu_level = cpuLevel();
+    if(level == DECODER_AUTO || level > cpu_level)
+    {
+        level = cpu_level;
+    }
+    level_in_use = level;
+    if(level == DECODER_AVX2)
+    {
+        decode_func = decodeBlocksAVX2;
+    }
+    else if(level == DECODER_SSE41)
+    {
+        decode_func = decodeBlocksSSE41;
+    }
+    else
+    {
+        decode_func = decodeBlocksScalar;
+    }
+}
+
+int VeloDecoder::cpuLevel()
+{
+    __builtin_cpu_init();
+    if(__builtin_cpu_supports("avx2"))
+    {
+        return DECODER_AVX2;
+    }
+    if(__builtin_cpu_supports("sse4.1"))
+    {
+        return DECODER_SSE41;
+    }
+    return DECODER_SCALAR;
+}
+
+void VeloDecoder::decode(const unsigned char *packet, DecodedPacket &decoded_packet)
+{
+    decode_func(packet,12,decoded_packet.distance,decoded_packet.intensity,
+                decoded_packet.upper_or_lower,decoded_packet.rot_angle);
+    const unsigned char * p_tail = packet + 12 * BLOCK_SIZE;
+    decoded_packet.gps_time_stampe = p_tail[0] + (p_tail[1]<<8) + (p_tail[2]<<16) + ((unsigned int)p_tail[3]<<24);
+    decoded_packet.gps_status_type = p_tail[4];
+    decoded_packet.gps_status_value = p_tail[5];
+}
@@ -1,122 +1,365 @@
 #include <string.h>
 #include <stdlib.h>
-#include <unistd.h>
 #include <stdio.h>
-#include <sys/socket.h>
-#include <arpa/inet.h>
-#include <poll.h>
 #include <errno.h>
-#include <fcntl.h>
-#include <sys/file.h>
+#include <time.h>
 
 #include "common.h"
 #include "velo_driver.h"
+#include "velo_frame.h"
 
 
 /** @brief constructor
  *  @param device IP in char array
  *  @param data port
+ *  @param configure of the driver, nullptr for the default one
  */
-VeloDriver::VeloDriver(const char *device_ip, const unsigned int data_port)
+VeloDriver::VeloDriver(const char *device_ip, const unsigned int data_port, const DriverConfig *driver_config)
 {
     //stp1. init the member variables
-    variableInit();
-    //stp2. communicate with device
-    startComm(device_ip,data_port);
+    variableInit(driver_config);
+    //stp2. communicate with device, or open the capture to replay
+    if(config.pcap_file != nullptr)
+    {
+        source = new PcapSource(config.pcap_file,device_ip,data_port,config.replay_mode);
+    }
+    else
+    {
+        source = new UdpSource(device_ip,data_port,config.batch_num);
+    }
+    own_source = true;
     //stp3. start recv thread
     recv_thread_handle = std::thread(recvThread,this);
-    recv_thread_handle.detach();
+}
+
+/** @brief constructor
+ *  @param packet source, not owned by the driver
+ *  @param configure of the driver, nullptr for the default one
+ */
+VeloDriver::VeloDriver(PacketSource *packet_source, const DriverConfig *driver_config)
+{
+    variableInit(driver_config);
+    source = packet_source;
+    own_source = false;
+    recv_thread_handle = std::thread(recvThread,this);
 }
 
 VeloDriver::~VeloDriver()
 {
-    //stp1. free variables
+    //stp1. stop the recv thread, it may sleep in poll() or on a full queue
+    recv_stop = true;
+    pthread_mutex_lock(&pack_lock);
+    pthread_cond_signal(&pack_free_signal);
+    pthread_mutex_unlock(&pack_lock);
+    recv_thread_handle.join();
+    //stp2. free variables and the source
     variableFree();
-    //stp2. close socket
-    (void)close(sock_fd);
+    if(own_source)
+    {
+        delete source;
+    }
 }
 
-void VeloDriver::variableInit()
+void VeloDriver::variableInit(const DriverConfig *driver_config)
 {
-    sock_fd = -1;
+    defaultConfig(config);
+    if(driver_config != nullptr)
+    {
+        memcpy(&config,driver_config,sizeof(DriverConfig));
+    }
+    if(config.batch_num < 1)
+    {
+        config.batch_num = 1;
+    }
+    if(config.queue_depth < 1)
+    {
+        config.queue_depth = 1;
+    }
+    config.cut_angle %= 36000;
+    if(config.laser_num != 0 && config.laser_num != 16 && config.laser_num != 32)
+    {
+        config.laser_num = 64;
+    }
+    if(config.rpm == 0)
+    {
+        config.rpm = 600;
+    }
+
+    source = nullptr;
+    own_source = false;
+    recv_stop = false;
+    recv_end = false;
     frame_id = 0;
     curr_rot_ang = 0;
     last_rot_ang = 0;
+    rot_ang_valid = false;
+    cut_rot_ang = config.cut_angle;
+    sector_rot_ang = (config.cut_angle + config.sector_angle) % 36000;
+    sector_packet_num = 0;
+    sector_id = 0;
 
     pthread_mutex_init(&pack_lock,nullptr);
     pthread_cond_init(&pack_new_signal,nullptr);
+    pthread_cond_init(&pack_free_signal,nullptr);
+    consumer_waiting = false;
+    producer_waiting = false;
+
+    //one buffer is filled, one is held by the consumer, the rest fit in the queue,
+    //so the free queue is never empty when the recv thread needs a buffer.
+    //the buffers themselves wait for the first packet, see setupSensor()
+    pool_num = config.queue_depth + 2;
+    frame_pool = new FrameData_ptr[pool_num];
+    for(unsigned int i = 0; i < pool_num; i++)
+    {
+        frame_pool[i] = nullptr;
+    }
+    pass_queue = new FrameQueue(config.queue_depth);
+    free_queue = new FrameQueue(pool_num);
+    recv_data = nullptr;
+    recv_overflow = false;
+    conv_block_num = 0;
+    raw_data = nullptr;
 
-    recv_data = new FrameData;
-    pass_data = new FrameData;
-    raw_data = new FrameData;
+    recv_packets = 0;
+    queued_frames = 0;
+    dropped_frames = 0;
+    overwritten_frames = 0;
+    overflow_blocks = 0;
+    sensor.model = MODEL_UNKNOWN;
+    sensor.return_mode = RETURN_STRONGEST;
+    analyse_blocks = nullptr;
 
-    memset(recv_data,0,sizeof(FrameData));
-    memset(pass_data,0,sizeof(FrameData));
-    memset(raw_data,0,sizeof(FrameData));
+    batch_packets = new const char *[config.batch_num];
+    batch_lens = new int[config.batch_num];
 }
 
 void VeloDriver::variableFree()
 {
-    if(recv_data)
+    for(unsigned int i = 0; i < pool_num && frame_pool[i] != nullptr; i++)
     {
-        delete recv_data;
-    }
-    if(pass_data)
-    {
-        delete pass_data;
+        if(frame_pool[i]->cloud != nullptr)
+        {
+            freeCloudXYZI(frame_pool[i]->cloud);
+        }
+        freeFrameData(frame_pool[i]);
     }
-    if(raw_data)
+    delete [] frame_pool;
+    delete pass_queue;
+    delete free_queue;
+    recv_data = nullptr;
+    raw_data = nullptr;
+    delete [] batch_packets;
+    delete [] batch_lens;
+}
+
+void VeloDriver::defaultConfig(DriverConfig &driver_config)
+{
+    memset(&driver_config,0,sizeof(DriverConfig));
+    driver_config.batch_num = 1;
+    driver_config.queue_depth = 2;
+    driver_config.drop_policy = QUEUE_DROP_OLDEST;
+    driver_config.cut_angle = 18000;
+    driver_config.sector_angle = 0;
+    driver_config.sector_packets = 0;
+    driver_config.pcap_file = nullptr;
+    driver_config.replay_mode = REPLAY_REALTIME;
+    driver_config.laser_num = 0;
+    driver_config.rpm = 600;
+    driver_config.calib = nullptr;
+}
+
+void VeloDriver::setCutAngle(unsigned int cut_angle)
+{
+    cut_rot_ang = cut_angle % 36000;
+}
+
+bool VeloDriver::passAngle(unsigned int last, unsigned int curr, unsigned int target)
+{
+    //only forward moves shorter than half a circle count, jitter backwards does not
+    unsigned int step = (curr + 36000 - last) % 36000;
+    unsigned int offset = (target + 36000 - last) % 36000;
+    return step < 18000 && offset > 0 && offset <= step;
+}
+
+void VeloDriver::getStats(DriverStats &stats)
+{
+    stats.poll_calls = source->getPollCalls();
+    stats.recv_calls = source->getRecvCalls();
+    stats.recv_packets = recv_packets;
+    stats.queued_frames = queued_frames;
+    stats.dropped_frames = dropped_frames;
+    stats.overwritten_frames = overwritten_frames;
+    stats.overflow_blocks = overflow_blocks;
+}
+
+int VeloDriver::newData()
+{
+    releaseData();
+    while(true)
     {
-        delete raw_data;
+        if(takeFrame())
+        {
+            return 1;
+        }
+        if(recv_end && pass_queue->empty())
+        {
+            return 0;
+        }
+        //sleep until the recv thread queues a frame, the flag is raised before
+        //the last check so that a push in between is either seen here or signalled
+        pthread_mutex_lock(&pack_lock);
+        consumer_waiting = true;
+        if(pass_queue->empty() && !recv_end)
+        {
+            pthread_cond_wait(&pack_new_signal,&pack_lock);
+        }
+        consumer_waiting = false;
+        pthread_mutex_unlock(&pack_lock);
     }
 }
 
-void VeloDriver::startComm(const char * device_ip,const unsigned int data_port)
+int VeloDriver::tryNewData()
 {
-    //open the socket and bind with the device ip
-    if (device_ip!=nullptr)
+    releaseData();
+    return takeFrame();
+}
+
+int VeloDriver::timedNewData(unsigned int timeout_ms)
+{
+    releaseData();
+    timespec deadline;
+    clock_gettime(CLOCK_REALTIME,&deadline);
+    deadline.tv_sec += timeout_ms / 1000;
+    deadline.tv_nsec += (long)(timeout_ms % 1000) * 1000000;
+    if(deadline.tv_nsec >= 1000000000)
     {
-        inet_aton(device_ip,&dev_ip);
+        deadline.tv_sec ++;
+        deadline.tv_nsec -= 1000000000;
     }
-    sock_fd = socket(PF_INET, SOCK_DGRAM, 0);
-    if (sock_fd == -1)
+    while(true)
     {
-        perror("socket");
-        return;
+        if(takeFrame())
+        {
+            return 1;
+        }
+        if(recv_end && pass_queue->empty())
+        {
+            return 0;
+        }
+        int wait_key = 0;
+        pthread_mutex_lock(&pack_lock);
+        consumer_waiting = true;
+        if(pass_queue->empty() && !recv_end)
+        {
+            wait_key = pthread_cond_timedwait(&pack_new_signal,&pack_lock,&deadline);
+        }
+        consumer_waiting = false;
+        pthread_mutex_unlock(&pack_lock);
+        if(wait_key == ETIMEDOUT)
+        {
+            return takeFrame();
+        }
     }
-    sockaddr_in my_addr;                     // my address information
-    memset(&my_addr, 0, sizeof(my_addr));    // initialize to zeros
-    my_addr.sin_family = AF_INET;            // host byte order
-    my_addr.sin_port = htons(data_port);     // port in network byte order
-    my_addr.sin_addr.s_addr = INADDR_ANY;    // automatically fill in my IP
-    if (bind(sock_fd, (sockaddr *)&my_addr, sizeof(sockaddr)) == -1)
+}
+
+void VeloDriver::releaseData()
+{
+    if(raw_data != nullptr)
     {
-        perror("bind");
-        return;
+        free_queue->push(raw_data);
+        raw_data = nullptr;
     }
-    if (fcntl(sock_fd,F_SETFL, O_NONBLOCK|FASYNC) < 0)
+}
+
+int VeloDriver::takeFrame()
+{
+    raw_data = pass_queue->pop();
+    if(raw_data == nullptr)
     {
-        perror("non-block");
-        return;
+        return 0;
+    }
+    if(producer_waiting)
+    {
+        pthread_mutex_lock(&pack_lock);
+        pthread_cond_signal(&pack_free_signal);
+        pthread_mutex_unlock(&pack_lock);
     }
+    return 1;
 }
 
-int VeloDriver::newData()
+/** @brief queue the finished recv_data and take a fresh buffer, a full queue
+ *  is resolved by the drop policy
+ *  @param whether recv_data ends the frame or is a sector of it
+ */
+void VeloDriver::publishFrame(bool last_sector)
 {
-    memset(raw_data,0,sizeof(FrameData));
-    //TODO:modify into timedwait and multiple return values
-    pthread_mutex_lock(&pack_lock);
-    pthread_cond_wait(&pack_new_signal,&pack_lock);
-    memcpy(raw_data,pass_data,sizeof(FrameData));
-    pthread_mutex_unlock(&pack_lock);
-    memset(pass_data,0,sizeof(FrameData));
-    return 1;
+    convertBlocks();
+    recv_data->frame_id = frame_id;
+    recv_data->sector_id = sector_id;
+    recv_data->last_sector = last_sector ? 1 : 0;
+    if(pass_queue->push(recv_data))
+    {
+        queued_frames ++;
+        recv_data = free_queue->pop();
+    }
+    else if(config.drop_policy == QUEUE_DROP_NEWEST)
+    {
+        //keep filling the same buffer
+        dropped_frames ++;
+    }
+    else if(config.drop_policy == QUEUE_BLOCK)
+    {
+        pthread_mutex_lock(&pack_lock);
+        producer_waiting = true;
+        bool pushed = false;
+        while(!(pushed = pass_queue->push(recv_data)) && !recv_stop)
+        {
+            pthread_cond_wait(&pack_free_signal,&pack_lock);
+        }
+        producer_waiting = false;
+        pthread_mutex_unlock(&pack_lock);
+        if(pushed)
+        {
+            queued_frames ++;
+            recv_data = free_queue->pop();
+        }
+    }
+    else
+    {
+        //reuse the oldest queued buffer, the consumer may have emptied the queue meanwhile
+        FrameData_ptr oldest = pass_queue->pop();
+        pass_queue->push(recv_data);
+        queued_frames ++;
+        if(oldest != nullptr)
+        {
+            overwritten_frames ++;
+            recv_data = oldest;
+        }
+        else
+        {
+            recv_data = free_queue->pop();
+        }
+    }
+    recv_data->block_num = 0;
+    recv_overflow = false;
+    conv_block_num = 0;
+    if(recv_data->cloud != nullptr)
+    {
+        recv_data->cloud->point_num = 0;
+    }
+
+    if(consumer_waiting)
+    {
+        pthread_mutex_lock(&pack_lock);
+        pthread_cond_signal(&pack_new_signal);
+        pthread_mutex_unlock(&pack_lock);
+    }
 }
 
 void VeloDriver::recvThread(void * arg)
 {
     VeloDriver * p_this = (VeloDriver*) arg;
-    while(true)
+    while(!p_this->recv_stop)
     {
         int p_key = p_this->getPacket();
         if(p_key!=0)
@@ -124,96 +367,30 @@ void VeloDriver::recvThread(void * arg)
             break;
         }
     }
+    //wake a consumer waiting for frames that will not come
+    p_this->recv_end = true;
+    pthread_mutex_lock(&p_this->pack_lock);
+    pthread_cond_signal(&p_this->pack_new_signal);
+    pthread_mutex_unlock(&p_this->pack_lock);
     return;
 }
 
+/** @brief take up to batch_num packets from the source and analyse them in a burst
+ *  @return 0: ok or timeout; 1: end of the source or error
+ */
 int VeloDriver::getPacket()
 {
-    //stp1.init socket variables for timeout function
-    struct pollfd fds[1];
-    fds[0].fd = sock_fd;
-    fds[0].events = POLLIN;
-    static const int POLL_TIMEOUT = 1*1000; // 120 seconds (in msec)
-
-    sockaddr_in sender_address;
-    socklen_t sender_address_len = sizeof(sender_address);
-
-    //stp2.init the variables in intermediate process
-    char buff[2048];
-    while (true)
-    {
-        //stp3-1. timeout function
-        // the Linux kernel recvfrom() implementation
-        // uses a non-interruptible sleep() when waiting for data,
-        // which would cause this method to hang if the device is not
-        // providing data.  We poll() the device first to make sure
-        // the recvfrom() will not block.
-        //
-        // Note, however, that there is a known Linux kernel bug:
-        //
-        //   Under Linux, select() may report a socket file descriptor
-        //   as "ready for reading", while nevertheless a subsequent
-        //   read blocks.  This could for example happen when data has
-        //   arrived but upon examination has wrong checksum and is
-        //   discarded.  There may be other circumstances in which a
-        //   file descriptor is spuriously reported as ready.  Thus it
-        //   may be safer to use O_NONBLOCK on sockets that should not
-        //   block.
-        // poll() until input available
-        do
-        {
-            int retval = poll(fds, 1, POLL_TIMEOUT);
-            if (retval < 0)             // poll() error?
-            {
-                if (errno != EINTR)
-                    perror("poll() error");
-                return 1;
-            }
-            if (retval == 0)            // poll() timeout?
-            {
-                printf("WRN:Velodyne poll() timeout\n");
-                return 0;
-            }
-            if ((fds[0].revents & POLLERR)
-                    || (fds[0].revents & POLLHUP)
-                    || (fds[0].revents & POLLNVAL)) // device error?
-            {
-                printf("ERRO:poll() reports Velodyne error\n");
-                return 1;
-            }
-        } while ((fds[0].revents & POLLIN) == 0);
-
-        //stp3-2.Receive packets that should now be available from the
-        //socket using a blocking read.
-        memset(buff,0,2048);
-        ssize_t nbytes = recvfrom(sock_fd, buff, 2048,  0,
-                                  (sockaddr*) &sender_address,
-                                  &sender_address_len);
-        if (nbytes < 0)
-        {
-            if (errno != EWOULDBLOCK)
-            {
-                perror("recvfail");
-                return 1;
-            }
-            break;
-        }
-        else
-        {
-            analysePacket(buff,nbytes);
-            if(sender_address.sin_addr.s_addr != dev_ip.s_addr)
-            {
-                printf("WRN:recv ip is not the same with device ip\n");
-                continue;
-            }
-            else
-            {
-                //printf("LOG:recv ok\n");
-                break;
-            }
-            break;
-        }
+    int npackets = source->nextPackets(batch_packets,batch_lens,config.batch_num);
+    if(npackets < 0)
+    {
+        return 1;
+    }
+    for(int i = 0; i < npackets; i++)
+    {
+        analysePacket(batch_packets[i],batch_lens[i]);
+        convertBlocks();
     }
+    recv_packets += npackets;
     return 0;
 }
 
@@ -221,36 +398,84 @@ int VeloDriver::getPacket()
  *  @param buffer address
  *  @param length of the receiving buffer
  */
-void VeloDriver::analysePacket(char* buf, int len)
+void VeloDriver::analysePacket(const char* buf, int len)
 {
     if(len != PACKET_SIZE)
     {
         printf("WRN:package erro, not the correct size\n");
         return;
     }
-    unsigned char * p_data = (unsigned char *)buf;
+    const unsigned char * p_data = (const unsigned char *)buf;
+    if(analyse_blocks == nullptr && !setupSensor(p_data))
+    {
+        printf("WRN:package erro, no known lidar model\n");
+        return;
+    }
+    (this->*analyse_blocks)(p_data);
+}
+
+/** @brief the 12 blocks of one packet into recv_data, cut at the frame and sector angles
+ *  @param packet of the model and return mode given
+ */
+template <int Model, int Return>
+void VeloDriver::analyseBlocks(const unsigned char *p_data)
+{
     unsigned int temp_time_stampe = p_data[1200] + (p_data[1201]<<8) + (p_data[1202]<<16) + (p_data[1203]<<24);  //10E-6 second
     unsigned char temp_status_type = (unsigned char)p_data[1204];
     unsigned char temp_status_value = (unsigned char)p_data[1205];
+    //firing time of every block, from the layout of the model
+    unsigned int block_time_stampe[12];
+    blockTimeStampeT<Model,Return>(temp_time_stampe,block_time_stampe);
     int block_index = 0;
     int laser_index = 0;
+    unsigned int cut_ang = cut_rot_ang;
     //every packet have 12 blocks
     while(block_index < 12)
     {
         //100 * degree of the scan angle, 0-36000
         curr_rot_ang = (p_data[3]<<8) + p_data[2];
-        if(last_rot_ang != 0&&curr_rot_ang >= 18000 && last_rot_ang < 18000)
+        if(rot_ang_valid && passAngle(last_rot_ang,curr_rot_ang,cut_ang))
         {
-            //cut the continuous data into frames at the 180 degree point
-            recv_data->frame_id = frame_id;
-            pthread_mutex_lock(&pack_lock);
-            memcpy(pass_data,recv_data,sizeof(FrameData));
-            pthread_cond_signal(&pack_new_signal);
-            pthread_mutex_unlock(&pack_lock);
+            //cut the continuous data into frames at the determining angle
+            //hand the filled buffer over by pointer
+            publishFrame(true);
             frame_id ++;
-            memset(recv_data,0,sizeof(FrameData));
+            sector_id = 0;
+            sector_packet_num = 0;
+            sector_rot_ang = (cut_ang + config.sector_angle) % 36000;
+        }
+        else if(rot_ang_valid && config.sector_angle > 0 && passAngle(last_rot_ang,curr_rot_ang,sector_rot_ang))
+        {
+            //publish the finished sector of the current frame
+            publishFrame(false);
+            sector_id ++;
+            sector_packet_num = 0;
+            sector_rot_ang = (sector_rot_ang + config.sector_angle) % 36000;
+        }
+        else if(block_index == 0 && config.sector_packets > 0 && sector_packet_num >= config.sector_packets)
+        {
+            //publish the sector once it holds sector_packets packets
+            publishFrame(false);
+            sector_id ++;
+            sector_packet_num = 0;
         }
 
+        //a frame longer than one revolution at the configured RPM, keep the
+        //blocks already stored and count the rest until the next cut
+        if(recv_data->block_num >= recv_data->max_block_num)
+        {
+            if(!recv_overflow)
+            {
+                printf("WRN:frame %u is full at %u blocks, check laser_num and rpm\n",frame_id,recv_data->max_block_num);
+                recv_overflow = true;
+            }
+            overflow_blocks ++;
+            p_data += 100;
+            block_index ++;
+            last_rot_ang = curr_rot_ang;
+            rot_ang_valid = true;
+            continue;
+        }
         //resolve the raw data into FrameData struct
         recv_data->frame_block[recv_data->block_num].upper_or_lower = (p_data[1]<<8) + p_data[0];
         recv_data->frame_block[recv_data->block_num].block_id = block_index;
@@ -264,14 +489,77 @@ void VeloDriver::analysePacket(char* buf, int len)
             laser_index ++;
             p_data += 3;
         }
-        //TODO: analyse the timestamp of every block
-        recv_data->frame_block[recv_data->block_num].gps_time_stampe = temp_time_stampe;
+        recv_data->frame_block[recv_data->block_num].gps_time_stampe = block_time_stampe[block_index];
         recv_data->frame_block[recv_data->block_num].gps_status_type = temp_status_type;
         recv_data->frame_block[recv_data->block_num].gps_status_value = temp_status_value;
         recv_data->block_num ++;
         block_index ++;
         laser_index = 0;
         last_rot_ang = curr_rot_ang;
+        rot_ang_valid = true;
+    }
+    sector_packet_num ++;
+}
+
+/** @brief find the model and the return mode in the first packet, a configured laser_num
+ *  sets the model. pick the analysis of both and create the frame buffers for them
+ *  @param first packet
+ *  @return 1: ok; 0: the packet is of no known model
+ */
+int VeloDriver::setupSensor(const unsigned char *p_data)
+{
+    //stp1. model and return mode
+    SensorInfo info;
+    int known = detectSensor(p_data,info);
+    if(config.laser_num != 0)
+    {
+        info.model = config.laser_num == 16 ? MODEL_VLP16 : (config.laser_num == 32 ? MODEL_HDL32E : MODEL_HDL64E);
+    }
+    else if(!known)
+    {
+        return 0;
+    }
+    //stp2. the analysis with the firing times of both known at compile time
+    static const AnalyseFunc analyses[MODEL_NUM][RETURN_MODE_NUM] =
+    {
+        {&VeloDriver::analyseBlocks<MODEL_HDL64E,RETURN_STRONGEST>,&VeloDriver::analyseBlocks<MODEL_HDL64E,RETURN_LAST>,
+         &VeloDriver::analyseBlocks<MODEL_HDL64E,RETURN_DUAL>},
+        {&VeloDriver::analyseBlocks<MODEL_HDL32E,RETURN_STRONGEST>,&VeloDriver::analyseBlocks<MODEL_HDL32E,RETURN_LAST>,
+         &VeloDriver::analyseBlocks<MODEL_HDL32E,RETURN_DUAL>},
+        {&VeloDriver::analyseBlocks<MODEL_VLP16,RETURN_STRONGEST>,&VeloDriver::analyseBlocks<MODEL_VLP16,RETURN_LAST>,
+         &VeloDriver::analyseBlocks<MODEL_VLP16,RETURN_DUAL>}
+    };
+    analyse_blocks = analyses[info.model][info.return_mode];
+    //stp3. frame buffers sized for one revolution of the sensor and cleared once here,
+    //afterwards only block_num is reset. dual return fills twice the blocks
+    unsigned int max_block_num = frameBlockNum(info,config.rpm);
+    for(unsigned int i = 0; i < pool_num; i++)
+    {
+        frame_pool[i] = createFrameData(max_block_num);
+        if(config.calib != nullptr)
+        {
+            frame_pool[i]->cloud = createCloudXYZI(max_block_num * 32);
+        }
+        free_queue->push(frame_pool[i]);
+    }
+    recv_data = free_queue->pop();
+    sensor = info;
+    const char * model_names[MODEL_NUM] = {"HDL-64E","HDL-32E","VLP-16"};
+    const char * return_names[RETURN_MODE_NUM] = {"strongest","last","dual"};
+    printf("LOG:%s, %s return, frames of %u blocks\n",model_names[info.model],return_names[info.return_mode],max_block_num);
+    return 1;
+}
+
+/** @brief convert the blocks of recv_data received since the last call into its cloud,
+ *  after every packet and before a frame cut, nothing is left for the consumer
+ */
+void VeloDriver::convertBlocks()
+{
+    if(config.calib == nullptr || recv_data == nullptr || conv_block_num >= recv_data->block_num)
+    {
+        return;
     }
+    config.calib->convBlocks(recv_data->frame_block + conv_block_num,recv_data->block_num - conv_block_num,*recv_data->cloud);
+    conv_block_num = recv_data->block_num;
 }
 
@@ -0,0 +1,348 @@
+#include "velo_frame.h"
+#include <string.h>
+
+//first 4 bytes of a compact dump
+#define COMPACT_MAGIC   0x31465643    //"CVF1"
+
+//blocks of one revolution plus 20% at rate blocks per second, rounded up to whole packets
+static unsigned int revolutionBlockNum(unsigned long long rate, unsigned int rpm)
+{
+    if(rpm == 0)
+    {
+        rpm = 600;
+    }
+    unsigned long long blocks = (rate * 60 * 12 + rpm * 10 - 1) / (rpm * 10);
+    return (unsigned int)((blocks + 11) / 12 * 12);
+}
+
+//model of a laser number, anything but 16 and 32 is a 64E
+static int laserModel(int laser_num)
+{
+    return laser_num == 16 ? MODEL_VLP16 : (laser_num == 32 ? MODEL_HDL32E : MODEL_HDL64E);
+}
+
+unsigned int frameBlockNum(int laser_num, unsigned int rpm)
+{
+    return revolutionBlockNum(sensorLayout(laserModel(laser_num)).block_rate,rpm);
+}
+
+unsigned int frameBlockNum(const SensorInfo &sensor, unsigned int rpm)
+{
+    unsigned long long rate = sensorLayout(sensor.model).block_rate;
+    return revolutionBlockNum(sensor.return_mode == RETURN_DUAL ? rate * 2 : rate,rpm);
+}
+
+unsigned int frameLinePointNum(int laser_num, unsigned int rpm)
+{
+    return frameBlockNum(laser_num,rpm) * 32 / sensorLayout(laserModel(laser_num)).laser_num;
+}
+
+unsigned int frameLinePointNum(const SensorInfo &sensor, unsigned int rpm)
+{
+    return frameBlockNum(sensor,rpm) * 32 / sensorLayout(sensor.model).laser_num;
+}
+
+FrameData_ptr createFrameData(unsigned int max_block_num)
+{
+    FrameData_ptr frame = new FrameData;
+    memset(frame,0,sizeof(FrameData));
+    frame->max_block_num = max_block_num;
+    frame->frame_block = new Block[max_block_num];
+    memset(frame->frame_block,0,sizeof(Block) * max_block_num);
+    return frame;
+}
+
+void freeFrameData(FrameData_ptr frame)
+{
+    if(frame != nullptr)
+    {
+        delete [] frame->frame_block;
+        delete frame;
+    }
+}
+
+CompactFrame_ptr createCompactFrame(unsigned int max_block_num)
+{
+    //one allocation, the arrays follow each other from the widest element down
+    size_t n = max_block_num;
+    size_t row_bytes = sizeof(unsigned short) * 32 + 32;
+    size_t bytes = n * (row_bytes + sizeof(unsigned int) + 2 * sizeof(unsigned short) + 3);
+    unsigned char * buf = new unsigned char[bytes];
+    memset(buf,0,bytes);
+    CompactFrame_ptr compact = new CompactFrame;
+    memset(compact,0,sizeof(CompactFrame));
+    compact->max_block_num = max_block_num;
+    compact->distance = (unsigned short (*)[32])buf;
+    buf += n * sizeof(unsigned short) * 32;
+    compact->gps_time_stampe = (unsigned int *)buf;
+    buf += n * sizeof(unsigned int);
+    compact->upper_or_lower = (unsigned short *)buf;
+    buf += n * sizeof(unsigned short);
+    compact->rot_angle = (unsigned short *)buf;
+    buf += n * sizeof(unsigned short);
+    compact->intensity = (unsigned char (*)[32])buf;
+    buf += n * 32;
+    compact->block_id = buf;
+    compact->gps_status_type = buf + n;
+    compact->gps_status_value = buf + 2 * n;
+    return compact;
+}
+
+void freeCompactFrame(CompactFrame_ptr compact)
+{
+    if(compact != nullptr)
+    {
+        delete [] (unsigned char *)compact->distance;
+        delete compact;
+    }
+}
+
+//one allocation of LASER_NUM lines of max_line_point points, lines[i] at the start of line i
+template <typename Point>
+static void createLines(Point ** lines, unsigned int max_line_point)
+{
+    Point * buf = new Point[(size_t)LASER_NUM * max_line_point];
+    memset(buf,0,sizeof(Point) * LASER_NUM * max_line_point);
+    for(int i = 0; i < LASER_NUM; i++)
+    {
+        lines[i] = buf + (size_t)i * max_line_point;
+    }
+}
+
+OriginData_ptr createOriginData(unsigned int max_line_point)
+{
+    OriginData_ptr origin = new OriginData;
+    memset(origin,0,sizeof(OriginData));
+    origin->max_line_point = max_line_point;
+    createLines(origin->line_point,max_line_point);
+    return origin;
+}
+
+void freeOriginData(OriginData_ptr origin)
+{
+    if(origin != nullptr)
+    {
+        delete [] origin->line_point[0];
+        delete origin;
+    }
+}
+
+PointCloud_ptr createPointCloud(unsigned int max_line_point)
+{
+    PointCloud_ptr cloud = new PointCloud;
+    memset(cloud,0,sizeof(PointCloud));
+    cloud->max_line_point = max_line_point;
+    createLines(cloud->line_point_cloud,max_line_point);
+    return cloud;
+}
+
+void freePointCloud(PointCloud_ptr cloud)
+{
+    if(cloud != nullptr)
+    {
+        delete [] cloud->line_point_cloud[0];
+        delete cloud;
+    }
+}
+
+void frameToCompact(const FrameData *frame, CompactFrame *compact)
+{
+    unsigned int n = frame->block_num < compact->max_block_num ? frame->block_num : compact->max_block_num;
+    compact->frame_id = frame->frame_id;
+    compact->block_num = n;
+    compact->sector_id = frame->sector_id;
+    compact->last_sector = frame->last_sector;
+    for(unsigned int i = 0; i < n; i++)
+    {
+        const Block & block = frame->frame_block[i];
+        for(int k = 0; k < 32; k++)
+        {
+            compact->distance[i][k] = (unsigned short)block.fire_laser[k].distance;
+            compact->intensity[i][k] = block.fire_laser[k].intensity;
+        }
+        compact->upper_or_lower[i] = block.upper_or_lower;
+        compact->rot_angle[i] = block.rot_angle;
+        compact->gps_time_stampe[i] = block.gps_time_stampe;
+        compact->block_id[i] = (unsigned char)block.block_id;
+        compact->gps_status_type[i] = block.gps_status_type;
+        compact->gps_status_value[i] = block.gps_status_value;
+    }
+}
+
+void compactToFrame(const CompactFrame *compact, FrameData *frame)
+{
+    unsigned int n = compact->block_num < frame->max_block_num ? compact->block_num : frame->max_block_num;
+    frame->frame_id = compact->frame_id;
+    frame->block_num = n;
+    frame->sector_id = compact->sector_id;
+    frame->last_sector = compact->last_sector;
+    for(unsigned int i = 0; i < n; i++)
+    {
+        Block & block = frame->frame_block[i];
+        for(int k = 0; k < 32; k++)
+        {
+            block.fire_laser[k].distance = compact->distance[i][k];
+            block.fire_laser[k].intensity = compact->intensity[i][k];
+        }
+        block.upper_or_lower = compact->upper_or_lower[i];
+        block.rot_angle = compact->rot_angle[i];
+        block.gps_time_stampe = compact->gps_time_stampe[i];
+        block.block_id = compact->block_id[i];
+        block.gps_status_type = compact->gps_status_type[i];
+        block.gps_status_value = compact->gps_status_value[i];
+    }
+}
+
+void blockTimeStampe(const unsigned short *upper_or_lower, unsigned int packet_time_stampe, unsigned int *time_stampe)
+{
+    //a packet holding lower blocks is a 64E one, its lower blocks fire with the upper block before them
+    bool pair = false;
+    for(int i = 0; i < 12; i++)
+    {
+        pair = pair || upper_or_lower[i] == 0xDDFF;
+    }
+    double period = sensorLayout(pair ? MODEL_HDL64E : MODEL_HDL32E).firing_period;
+    int firing = -1;
+    for(int i = 0; i < 12; i++)
+    {
+        if(!pair || upper_or_lower[i] != 0xDDFF || firing < 0)
+        {
+            firing ++;
+        }
+        unsigned int time = packet_time_stampe + (unsigned int)(firing * period + 0.5);
+        time_stampe[i] = time >= HOUR_US ? time - HOUR_US : time;
+    }
+}
+
+int appendPacket(VeloDecoder &decoder, const unsigned char *packet, CompactFrame *compact)
+{
+    unsigned int b = compact->block_num;
+    if(b + 12 > compact->max_block_num)
+    {
+        return 0;
+    }
+    decoder.decodeBlocks(packet,&compact->distance[b],&compact->intensity[b],
+                         &compact->upper_or_lower[b],&compact->rot_angle[b]);
+    const unsigned char * p_tail = packet + 1200;
+    unsigned int time_stampe = p_tail[0] + (p_tail[1]<<8) + (p_tail[2]<<16) + ((unsigned int)p_tail[3]<<24);
+    blockTimeStampe(&compact->upper_or_lower[b],time_stampe,&compact->gps_time_stampe[b]);
+    for(int i = 0; i < 12; i++)
+    {
+        compact->block_id[b + i] = i;
+        compact->gps_status_type[b + i] = p_tail[4];
+        compact->gps_status_value[b + i] = p_tail[5];
+    }
+    compact->block_num += 12;
+    return 1;
+}
+
+/** @brief appendPacket for the packets of one model and return mode, the layout is known at
+ *  compile time: blocks sharing a firing time and the time between them are constants
+ */
+template <int Model, int Return>
+static int appendPacketT(VeloDecoder &decoder, const unsigned char *packet, CompactFrame *compact)
+{
+    unsigned int b = compact->block_num;
+    if(b + 12 > compact->max_block_num)
+    {
+        return 0;
+    }
+    decoder.decodeBlocks(packet,&compact->distance[b],&compact->intensity[b],
+                         &compact->upper_or_lower[b],&compact->rot_angle[b]);
+    const unsigned char * p_tail = packet + 1200;
+    unsigned int time_stampe = p_tail[0] + (p_tail[1]<<8) + (p_tail[2]<<16) + ((unsigned int)p_tail[3]<<24);
+    blockTimeStampeT<Model,Return>(time_stampe,&compact->gps_time_stampe[b]);
+    for(int i = 0; i < 12; i++)
+    {
+        compact->block_id[b + i] = i;
+        compact->gps_status_type[b + i] = p_tail[4];
+        compact->gps_status_value[b + i] = p_tail[5];
+    }
+    compact->block_num += 12;
+    return 1;
+}
+
+AppendPacketFunc packetAppender(const SensorInfo &sensor)
+{
+    static const AppendPacketFunc appenders[MODEL_NUM][RETURN_MODE_NUM] =
+    {
+        {appendPacketT<MODEL_HDL64E,RETURN_STRONGEST>,appendPacketT<MODEL_HDL64E,RETURN_LAST>,appendPacketT<MODEL_HDL64E,RETURN_DUAL>},
+        {appendPacketT<MODEL_HDL32E,RETURN_STRONGEST>,appendPacketT<MODEL_HDL32E,RETURN_LAST>,appendPacketT<MODEL_HDL32E,RETURN_DUAL>},
+        {appendPacketT<MODEL_VLP16,RETURN_STRONGEST>,appendPacketT<MODEL_VLP16,RETURN_LAST>,appendPacketT<MODEL_VLP16,RETURN_DUAL>}
+    };
+    if(sensor.model <= MODEL_UNKNOWN || sensor.model >= MODEL_NUM ||
+       sensor.return_mode < RETURN_STRONGEST || sensor.return_mode >= RETURN_MODE_NUM)
+    {
+        return appendPacket;
+    }
+    return appenders[sensor.model][sensor.return_mode];
+}
+
+int saveCompactFrame(FILE *fp, const CompactFrame *compact)
+{
+    if(fp == nullptr)
+    {
+        return 0;
+    }
+    unsigned int n = compact->block_num;
+    unsigned int magic = COMPACT_MAGIC;
+    size_t ok = fwrite(&magic,sizeof(magic),1,fp);
+    ok &= fwrite(&compact->frame_id,sizeof(compact->frame_id),1,fp);
+    ok &= fwrite(&compact->block_num,sizeof(compact->block_num),1,fp);
+    ok &= fwrite(&compact->sector_id,sizeof(compact->sector_id),1,fp);
+    ok &= fwrite(&compact->last_sector,sizeof(compact->last_sector),1,fp);
+    if(n > 0)
+    {
+        ok &= fwrite(compact->distance,sizeof(compact->distance[0]),n,fp) == n;
+        ok &= fwrite(compact->intensity,sizeof(compact->intensity[0]),n,fp) == n;
+        ok &= fwrite(compact->upper_or_lower,sizeof(unsigned short),n,fp) == n;
+        ok &= fwrite(compact->rot_angle,sizeof(unsigned short),n,fp) == n;
+        ok &= fwrite(compact->gps_time_stampe,sizeof(unsigned int),n,fp) == n;
+        ok &= fwrite(compact->block_id,1,n,fp) == n;
+        ok &= fwrite(compact->gps_status_type,1,n,fp) == n;
+        ok &= fwrite(compact->gps_status_value,1,n,fp) == n;
+    }
+    return ok ? 1 : 0;
+}
+
+int loadCompactFrame(FILE *fp, CompactFrame *compact)
+{
+    if(fp == nullptr)
+    {
+        return 0;
+    }
+    unsigned int magic = 0;
+    size_t ok = fread(&magic,sizeof(magic),1,fp);
+    if(!ok || magic != COMPACT_MAGIC)
+    {
+        printf("ERRO:not a compact frame dump\n");
+        return 0;
+    }
+    ok &= fread(&compact->frame_id,sizeof(compact->frame_id),1,fp);
+    ok &= fread(&compact->block_num,sizeof(compact->block_num),1,fp);
+    ok &= fread(&compact->sector_id,sizeof(compact->sector_id),1,fp);
+    ok &= fread(&compact->last_sector,sizeof(compact->last_sector),1,fp);
+    unsigned int n = compact->block_num;
+    if(ok && n > compact->max_block_num)
+    {
+        printf("ERRO:compact dump holds %u blocks, the frame only %u\n",n,compact->max_block_num);
+        ok = 0;
+    }
+    if(!ok)
+    {
+        compact->block_num = 0;
+        return 0;
+    }
+    if(n > 0)
+    {
+        ok &= fread(compact->distance,sizeof(compact->distance[0]),n,fp) == n;
+        ok &= fread(compact->intensity,sizeof(compact->intensity[0]),n,fp) == n;
+        ok &= fread(compact->upper_or_lower,sizeof(unsigned short),n,fp) == n;
+        ok &= fread(compact->rot_angle,sizeof(unsigned short),n,fp) == n;
+        ok &= fread(compact->gps_time_stampe,sizeof(unsigned int),n,fp) == n;
+        ok &= fread(compact->block_id,1,n,fp) == n;
+        ok &= fread(compact->gps_status_type,1,n,fp) == n;
+        ok &= fread(compact->gps_status_value,1,n,fp) == n;
+    }
+    return ok ? 1 : 0;
+}
@@ -0,0 +1,152 @@
+#include "velo_generator.h"
+#include <string.h>
+#include <math.h>
+
+#define MAX_RANGE   120.0
+
+/** @brief constructor
+ *  @param configure of the generator, nullptr for the default one
+ */
+VeloGenerator::VeloGenerator(const GeneratorConfig *generator_config)
+{
+    defaultConfig(config);
+    if(generator_config != nullptr)
+    {
+        memcpy(&config,generator_config,sizeof(GeneratorConfig));
+    }
+    config.laser_num = config.laser_num > 32 ? 64 : (config.laser_num > 16 ? 32 : 16);
+    model = config.laser_num == 64 ? MODEL_HDL64E : (config.laser_num == 32 ? MODEL_HDL32E : MODEL_VLP16);
+    layout = sensorLayout(model);
+    //64E fires every 48 us, 32E every 46.08 us, VLP-16 every 55.296 us
+    firing_period = layout.firing_period;
+    rot_step = config.rpm / 60.0 * 36000.0 * firing_period * 1e-6;
+    rot_ang = config.start_angle % 36000;
+    time_stamp = 0;
+    //nominal vertical angles, 64E: +2 to -8.33 upper and -8.83 to -24.33 lower block,
+    //32E: +10.67 to -30.67, VLP-16: -15 to +15 every 2 degree, odd lasers above the horizon
+    for(int i = 0; i < 64; i++)
+    {
+        double vert_angle;
+        if(config.laser_num == 64)
+        {
+            vert_angle = i < 32 ? 2.0 - i * 10.33 / 31.0 : -8.83 - (i - 32) * 15.5 / 31.0;
+        }
+        else if(config.laser_num == 16)
+        {
+            vert_angle = i % 2 == 0 ? -15.0 + i % 16 : (double)(i % 16);
+        }
+        else
+        {
+            vert_angle = 10.67 - (i % 32) * 41.34 / 31.0;
+        }
+        sin_vert[i] = sin(vert_angle * M_PI / 180.0);
+        cos_vert[i] = cos(vert_angle * M_PI / 180.0);
+    }
+}
+
+void VeloGenerator::defaultConfig(GeneratorConfig &generator_config)
+{
+    memset(&generator_config,0,sizeof(GeneratorConfig));
+    generator_config.laser_num = 64;
+    generator_config.return_mode = RETURN_STRONGEST;
+    generator_config.rpm = 600;
+    generator_config.scene = SCENE_RING;
+    generator_config.height = 1.8;
+    generator_config.room_x = 20.0;
+    generator_config.room_y = 10.0;
+    generator_config.start_angle = 0;
+}
+
+double VeloGenerator::packetPeriod()
+{
+    //64E: 6 upper/lower firings, 32E: 12 firings, VLP-16: 24 firings per packet, half with dual return
+    int time_block_num = layout.block_per_firing * (config.return_mode == RETURN_DUAL ? 2 : 1);
+    return firing_period * layout.firing_per_block * 12 / time_block_num;
+}
+
+double VeloGenerator::wallRange(double azimuth)
+{
+    if(config.scene != SCENE_ROOM)
+    {
+        return MAX_RANGE + 1;
+    }
+    double rad = azimuth / 100.0 * M_PI / 180.0;
+    double wall_x = fabs(sin(rad)) > 1e-9 ? config.room_x / fabs(sin(rad)) : MAX_RANGE + 1;
+    double wall_y = fabs(cos(rad)) > 1e-9 ? config.room_y / fabs(cos(rad)) : MAX_RANGE + 1;
+    return wall_x < wall_y ? wall_x : wall_y;
+}
+
+unsigned short VeloGenerator::sceneDistance(int laser, double wall_range)
+{
+    double range = 10.0 + (laser % 32) + (laser >= 32 ? 0.5 : 0.0);
+    if(config.scene != SCENE_RING)
+    {
+        //ground below the horizon, then the closer wall
+        range = sin_vert[laser] < 0 ? config.height / -sin_vert[laser] : MAX_RANGE + 1;
+        double wall = wall_range / cos_vert[laser];
+        range = wall < range ? wall : range;
+    }
+    if(range > MAX_RANGE)
+    {
+        return 0;
+    }
+    return (unsigned short)(range * 500.0);
+}
+
+void VeloGenerator::buildPacket(unsigned char *packet)
+{
+    unsigned char * p_data = packet;
+    int firing_num = 0;
+    //blocks of one firing time: 64E upper then lower, each twice (last, strongest) with dual return
+    int return_num = config.return_mode == RETURN_DUAL ? 2 : 1;
+    int time_block_num = layout.block_per_firing * return_num;
+    for(int block_index = 0; block_index < 12; block_index++)
+    {
+        bool lower = model == MODEL_HDL64E && block_index % time_block_num >= return_num;
+        unsigned short header = lower ? 0xDDFF : 0xEEFF;
+        unsigned short angle = (unsigned short)rot_ang;
+        p_data[0] = header & 0xff;
+        p_data[1] = header >> 8;
+        p_data[2] = angle & 0xff;
+        p_data[3] = angle >> 8;
+        p_data += 4;
+        double wall_range[2] = {wallRange(rot_ang),wallRange(rot_ang + rot_step)};
+        for(int laser_index = 0; laser_index < 32; laser_index++)
+        {
+            //the VLP-16 fires its 16 lasers twice in a block, the second time one step later
+            int laser = model == MODEL_VLP16 ? laser_index % 16 : laser_index + (lower ? 32 : 0);
+            int firing = model == MODEL_VLP16 ? laser_index / 16 : 0;
+            //length of the scanning measure, (*2 mm)
+            unsigned short distance = sceneDistance(laser,wall_range[firing]);
+            p_data[0] = distance & 0xff;
+            p_data[1] = distance >> 8;
+            p_data[2] = distance == 0 ? 0 : (unsigned char)(20 + laser_index * 4 + (lower ? 100 : 0));
+            p_data += 3;
+        }
+        //the next firing once every block of this one is written
+        if(block_index % time_block_num == time_block_num - 1)
+        {
+            rot_ang += rot_step * layout.firing_per_block;
+            if(rot_ang >= 36000)
+            {
+                rot_ang -= 36000;
+            }
+            firing_num += layout.firing_per_block;
+        }
+    }
+    //timestamp of the first firing, us past the hour, and the status bytes
+    unsigned int packet_stamp = (unsigned int)time_stamp;
+    p_data[0] = packet_stamp & 0xff;
+    p_data[1] = (packet_stamp >> 8) & 0xff;
+    p_data[2] = (packet_stamp >> 16) & 0xff;
+    p_data[3] = packet_stamp >> 24;
+    //the 32E and the VLP-16 give their return mode and product id, the 64E its gps status
+    const unsigned char return_bytes[RETURN_MODE_NUM] = {0x37,0x38,0x39};
+    p_data[4] = model == MODEL_HDL64E ? 0 : return_bytes[config.return_mode];
+    p_data[5] = model == MODEL_HDL64E ? 0 : (model == MODEL_HDL32E ? 0x21 : 0x22);
+    time_stamp += firing_num * firing_period;
+    if(time_stamp >= 3600e6)
+    {
+        time_stamp -= 3600e6;
+    }
+}